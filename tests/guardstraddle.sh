@@ -0,0 +1,58 @@
+#!/bin/sh
+# Ryan Bandilla
+# Y86 Guarded Straddle Test
+# BKR Comp Arch
+#
+# Builds y86emul and runs programs whose last access starts inside
+# memory and runs off its end, or lies wholly past it, in guarded memory
+# (-g) and on the switch engine, which must leave the same output and
+# memory.  Only the wording of the error differs, so ERROR lines are
+# left out of the comparison.
+#
+# Run from anywhere, with cc or $CC.
+
+set -e
+src=$(cd "$(dirname "$0")/.." && pwd)
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+cd "$src"
+${CC:-cc} -O2 -o "$tmp/y86emul" y86emul.c \
+	$(ls y86*.c | grep -v -e '^y86emul.c$' -e '^y86dis.c$' -e '^y86bench.c$' \
+		-e '^y86gen.c$' -e '^y86loadbench.c$') -lm -lpthread
+
+# .size 400 is 1024 bytes and the spare one, 0 to 400.  Every program
+# puts -1 in %eax first, then:
+#   rmmovl  %eax, 3ff		bytes 3ff to 402
+#   pushl   %eax with %esp 403
+#   call    0 with %esp 403
+#   readl   3ff, reading -1
+#   mrmovl  3ff, %eax
+#   writel  3ff
+#   writeb  1000
+failed=0
+for prog in \
+	30f3ff03000040030000000010 \
+	30f403040000a00f10 \
+	30f4030400008000000000 \
+	30f3ff030000c13f0000000010 \
+	30f3ff03000050030000000010 \
+	30f3ff030000d13f0000000010 \
+	30f300000000d13f0010000010
+do
+	printf '.size\t400\n.text\t0\t30f0ffffffff%s\n' "$prog" > "$tmp/straddle.y86"
+
+	echo -1 | "$tmp/y86emul" -e switch "$tmp/straddle.y86" 2>&1 | grep -v '^ERROR:' > "$tmp/switch.out" || true
+	echo -1 | "$tmp/y86emul" -g "$tmp/straddle.y86" 2>&1 | grep -v '^ERROR:' > "$tmp/guarded.out" || true
+	if ! cmp -s "$tmp/switch.out" "$tmp/guarded.out"
+	then
+		echo "guardstraddle: FAILED on $prog"
+		failed=1
+	fi
+done
+
+if [ $failed -ne 0 ]
+then
+	exit 1
+fi
+echo "guardstraddle: OK"
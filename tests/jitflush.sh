@@ -0,0 +1,68 @@
+#!/bin/sh
+# Ryan Bandilla
+# Y86 JIT Flush Test
+# BKR Comp Arch
+#
+# Builds y86emul with a 64 KiB JIT buffer and runs programs whose
+# translation fills it, on the JIT and the switch engine, which must
+# leave the same memory and registers.
+#
+# Each program jumps to a block B near the start of the buffer, runs a
+# long line of code that fills the buffer almost to the end, and comes
+# back to B, which now leaves for code that was never translated.  That
+# translation flushes the buffer and lands over B, so chaining B's exit
+# to it would write into the new code.  Which length of the long line
+# fills the buffer just so depends on the code the JIT emits, so a range
+# of them is run.
+#
+# Run from anywhere, with cc or $CC.
+
+set -e
+src=$(cd "$(dirname "$0")/.." && pwd)
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+cd "$src"
+${CC:-cc} -O2 -DJITCODESIZE=65536 -o "$tmp/y86emul" y86emul.c \
+	$(ls y86*.c | grep -v -e '^y86emul.c$' -e '^y86dis.c$' -e '^y86bench.c$' \
+		-e '^y86gen.c$' -e '^y86loadbench.c$') -lm -lpthread
+
+#   0: irmovl 2, %edi; irmovl 1, %esi; irmovl 1, %ecx; jmp 17
+#  17: subl %esi, %edi; jne 7ef		B, to the line the first time only
+#  1e: 1000 x addl %ecx, %eax; halt
+# 7ef: n x addl %ecx, %eax; jmp 17	The line filling the buffer
+failed=0
+n=600
+while [ $n -le 2400 ]
+do
+	awk -v n=$n 'BEGIN {
+		printf ".size\t10000\n.text\t0\t"
+		printf "30f70200000030f60100000030f1010000007017000000"
+		printf "616774ef070000"
+		for (i = 0; i < 1000; i++)
+		{
+			printf "6010"
+		}
+		printf "10"
+		for (i = 0; i < n; i++)
+		{
+			printf "6010"
+		}
+		printf "7017000000\n"
+	}' > "$tmp/flush.y86"
+
+	"$tmp/y86emul" -e switch "$tmp/flush.y86" > "$tmp/switch.out"
+	if ! "$tmp/y86emul" -e jit "$tmp/flush.y86" > "$tmp/jit.out" 2>&1 ||
+		! cmp -s "$tmp/switch.out" "$tmp/jit.out"
+	then
+		echo "jitflush: FAILED with a line of $n instructions"
+		failed=1
+	fi
+	n=$((n + 6))
+done
+
+if [ $failed -ne 0 ]
+then
+	exit 1
+fi
+echo "jitflush: OK"
@@ -0,0 +1,418 @@
+// Ryan Bandilla
+// Y86 Batch Runner
+// BKR Comp Arch
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "y86batch.h"
+
+/*
+	Runs still to be done by one worker, the indexes head up to tail.
+	The owner takes from the head, thieves take from the tail.
+*/
+
+typedef struct
+{
+	pthread_mutex_t lock;
+	int head;
+	int tail;
+} Deque;
+
+typedef struct Pool Pool;
+
+typedef struct
+{
+	Pool * pool;
+	int id;
+	pthread_t thread;
+} Worker;
+
+struct Pool
+{
+	const VM * prog;
+	BatchRun * runs;
+	Deque * deques;
+	Worker * workers;
+	int nworkers;
+};
+
+/*
+	Seconds on a monotonic clock, used to time the batch.
+*/
+
+static double now ()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+	Whether the file at path is a regular file.
+*/
+
+static int isfile (const char * path)
+{
+	struct stat st;
+	return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+/*
+	Adds a copy of name to the growing list of inputs.
+*/
+
+static int addinput (char *** inputs, int * n, int * cap, const char * name)
+{
+	if (*n == *cap)
+	{
+		int grown = *cap == 0 ? 64 : 2 * *cap;
+		char ** list = (char **) realloc(*inputs, grown * sizeof(char *));
+		if (list == NULL)
+		{
+			return -1;
+		}
+		*inputs = list;
+		*cap = grown;
+	}
+	if (((*inputs)[*n] = strdup(name)) == NULL)
+	{
+		return -1;
+	}
+	(*n)++;
+	return 0;
+}
+
+/*
+	The inputs of a batch.  path is either a directory, every regular file
+	in it is an input (in name order), or a file naming one input per line.
+	Returns the list, or NULL if path can't be read.
+*/
+
+char ** batchinputs (const char * path, int * n)
+{
+	char ** inputs = NULL;
+	int cap = 0;
+	int ok = 1;
+
+	*n = 0;
+
+	struct dirent ** names;
+	int count = scandir(path, &names, NULL, alphasort);
+
+	if (count >= 0)
+	{
+		char * full = (char *) malloc(strlen(path) + 258);
+		int i;
+
+		for (i = 0; i < count; i++)
+		{
+			if (ok && full != NULL)
+			{
+				sprintf(full, "%s/%s", path, names[i]->d_name);
+				if (isfile(full) && addinput(&inputs, n, &cap, full) != 0)
+				{
+					ok = 0;
+				}
+			}
+			free(names[i]);
+		}
+		free(names);
+		ok = ok && full != NULL;
+		free(full);
+	}
+	else
+	{
+		FILE * list = fopen(path, "r");
+		char * line = NULL;
+		size_t size = 0;
+		ssize_t len;
+
+		if (list == NULL)
+		{
+			return NULL;
+		}
+
+		while (ok && (len = getline(&line, &size, list)) >= 0)
+		{
+			while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+			{
+				line[--len] = '\0';
+			}
+			if (len > 0 && addinput(&inputs, n, &cap, line) != 0)
+			{
+				ok = 0;
+			}
+		}
+		free(line);
+		fclose(list);
+	}
+
+	if (!ok)
+	{
+		batchfreeinputs(inputs, *n);
+		*n = 0;
+		return NULL;
+	}
+	if (inputs == NULL)
+	{
+		inputs = (char **) malloc(sizeof(char *));
+	}
+	return inputs;
+}
+
+/*
+	Releases a list from batchinputs().
+*/
+
+void batchfreeinputs (char ** inputs, int n)
+{
+	int i;
+
+	if (inputs == NULL)
+	{
+		return;
+	}
+	for (i = 0; i < n; i++)
+	{
+		free(inputs[i]);
+	}
+	free(inputs);
+}
+
+/*
+	Takes the next run of the worker's own deque.  Returns -1 if it's empty.
+*/
+
+static int takeown (Deque * dq)
+{
+	int i = -1;
+
+	pthread_mutex_lock(&dq->lock);
+	if (dq->head < dq->tail)
+	{
+		i = dq->head++;
+	}
+	pthread_mutex_unlock(&dq->lock);
+	return i;
+}
+
+/*
+	Steals the back half of the first other deque with work left and moves
+	it to the worker's own, which is empty.  Returns -1 once every deque is
+	empty: runs are never added, so there will be nothing more to do.
+*/
+
+static int steal (Pool * pool, int id)
+{
+	Deque * own = &pool->deques[id];
+	int k;
+
+	for (k = 1; k < pool->nworkers; k++)
+	{
+		Deque * victim = &pool->deques[(id + k) % pool->nworkers];
+		int lo = 0, hi = 0;
+
+		pthread_mutex_lock(&victim->lock);
+		if (victim->head < victim->tail)
+		{
+			hi = victim->tail;
+			lo = hi - (hi - victim->head + 1) / 2;
+			victim->tail = lo;
+		}
+		pthread_mutex_unlock(&victim->lock);
+
+		if (lo < hi)
+		{
+			pthread_mutex_lock(&own->lock);
+			own->head = lo + 1;
+			own->tail = hi;
+			pthread_mutex_unlock(&own->lock);
+			return lo;
+		}
+	}
+	return -1;
+}
+
+/*
+	Runs one input on vm, a fresh copy of the program each time.
+*/
+
+static void runone (VM * vm, const VM * prog, BatchRun * run)
+{
+	FILE * in = fopen(run->input, "r");
+	FILE * out = open_memstream(&run->output, &run->outlen);
+	long long before;
+
+	if (in == NULL || out == NULL || vmcopy(vm, prog) != 0)
+	{
+		run->failed = 1;
+		run->status = AOK;
+	}
+	else
+	{
+		vm->in = in;
+		vm->out = out;
+		before = vm->icount;
+		run->status = vmrun(vm);
+		run->icount = vm->icount - before;
+	}
+
+	if (in != NULL)
+	{
+		fclose(in);
+	}
+	if (out != NULL)
+	{
+		fclose(out);
+	}
+}
+
+/*
+	Body of each thread of the pool: its own runs first, then other
+	workers' until there are none left.
+*/
+
+static void * work (void * arg)
+{
+	Worker * w = (Worker *) arg;
+	Pool * pool = w->pool;
+	VM * vm = vmcreate();
+	int i;
+
+	while ((i = takeown(&pool->deques[w->id])) >= 0 || (i = steal(pool, w->id)) >= 0)
+	{
+		if (vm == NULL)
+		{
+			pool->runs[i].failed = 1;
+			continue;
+		}
+		runone(vm, pool->prog, &pool->runs[i]);
+	}
+
+	vmdestroy(vm);
+	return NULL;
+}
+
+/*
+	Runs the loaded program prog once for every entry of runs, each with
+	the input named in it, on threads threads (0 for one per core).  prog
+	itself is never run or changed.  Load it with guard set, so a run
+	that goes outside of memory stops with ADR instead of killing the
+	whole batch.  The runs are handed out in blocks to
+	the threads and a thread that finishes its own block steals half of
+	another's, so a few long runs can't leave the rest of the cores idle.
+	Returns 0 when every run was attempted, or -1 if the pool couldn't be
+	started.
+*/
+
+int batchrun (const VM * prog, BatchRun * runs, int n, int threads, BatchStats * stats)
+{
+	Pool pool;
+	int i, started;
+	double start = now();
+
+	if (threads <= 0)
+	{
+		threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (threads > n)
+	{
+		threads = n;
+	}
+	if (threads < 1)
+	{
+		threads = 1;
+	}
+
+	memset(stats, 0, sizeof(BatchStats));
+	stats->threads = threads;
+
+	for (i = 0; i < n; i++)
+	{
+		runs[i].status = AOK;
+		runs[i].icount = 0;
+		runs[i].output = NULL;
+		runs[i].outlen = 0;
+		runs[i].failed = 0;
+	}
+
+	pool.prog = prog;
+	pool.runs = runs;
+	pool.nworkers = threads;
+	pool.deques = (Deque *) calloc(threads, sizeof(Deque));
+	pool.workers = (Worker *) calloc(threads, sizeof(Worker));
+
+	if (pool.deques == NULL || pool.workers == NULL)
+	{
+		free(pool.deques);
+		free(pool.workers);
+		return -1;
+	}
+
+	for (i = 0; i < threads; i++)
+	{
+		pthread_mutex_init(&pool.deques[i].lock, NULL);
+		pool.deques[i].head = (int) ((long long) n * i / threads);
+		pool.deques[i].tail = (int) ((long long) n * (i + 1) / threads);
+		pool.workers[i].pool = &pool;
+		pool.workers[i].id = i;
+	}
+
+	// Worker 0 is this thread, the rest are started for the batch.  If
+	// some can't be started the others steal their runs.
+	for (started = 1; started < threads; started++)
+	{
+		if (pthread_create(&pool.workers[started].thread, NULL, work, &pool.workers[started]) != 0)
+		{
+			break;
+		}
+	}
+	work(&pool.workers[0]);
+
+	for (i = 1; i < started; i++)
+	{
+		pthread_join(pool.workers[i].thread, NULL);
+	}
+	for (i = 0; i < threads; i++)
+	{
+		pthread_mutex_destroy(&pool.deques[i].lock);
+	}
+	free(pool.deques);
+	free(pool.workers);
+
+	stats->seconds = now() - start;
+	for (i = 0; i < n; i++)
+	{
+		if (runs[i].failed)
+		{
+			stats->failed++;
+		}
+		else
+		{
+			stats->count[runs[i].status]++;
+			stats->icount += runs[i].icount;
+		}
+	}
+	return 0;
+}
+
+/*
+	Releases the outputs of a batch.
+*/
+
+void batchfreeruns (BatchRun * runs, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+	{
+		free(runs[i].output);
+		runs[i].output = NULL;
+	}
+}
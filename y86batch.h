@@ -0,0 +1,45 @@
+// Ryan Bandilla
+// Y86 Batch Runner
+// BKR Comp Arch
+#ifndef Y86BATCH_H
+#define Y86BATCH_H
+
+#include <stddef.h>
+#include "y86vm.h"
+
+/*
+ *	One run of a batch: the program from its start with one file as its
+ *	input.  Filled in by batchrun(), the output is everything the run
+ *	wrote, from malloc and '\0' terminated.
+ */
+
+typedef struct
+{
+	const char * input;			//	File read by READB and READL
+	ProgramStatus status;
+	long long icount;			//	Instructions executed
+	char * output;
+	size_t outlen;
+	int failed;					//	The input couldn't be opened, nothing ran
+	int signal;					//	Killed the fork server's child, 0 for none
+} BatchRun;
+
+/*
+ *	Totals of a batch, see batchrun()
+ */
+
+typedef struct
+{
+	int threads;
+	double seconds;				//	Wall clock time of the whole batch
+	long long icount;
+	int count[TMO + 1];			//	Runs stopped with each ProgramStatus
+	int failed;
+} BatchStats;
+
+char ** batchinputs (const char * path, int * n);
+void batchfreeinputs (char ** inputs, int n);
+int batchrun (const VM * prog, BatchRun * runs, int n, int threads, BatchStats * stats);
+void batchfreeruns (BatchRun * runs, int n);
+
+#endif
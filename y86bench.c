@@ -0,0 +1,250 @@
+// Ryan Bandilla
+// Y86 Benchmark
+// BKR Comp Arch
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "y86vm.h"
+
+/*
+	Runs each kernel, such as those in bench/, on each engine for a fixed
+	wall time, in a child of its own so its peak RSS is its own, and
+	prints one tab separated line per run:
+
+		kernel engine runs instructions seconds ips ns_per_insn maxrss_kb status
+
+	A kernel that halts before the time is up is started again from its
+	loaded memory, runs counts how often it was started.  The time of
+	those restarts is counted in, so kernels should run a while each.
+*/
+
+typedef struct
+{
+	long long runs;
+	long long icount;
+	double secs;
+	ProgramStatus status;		//	Of the last run
+	int failed;					//	The kernel couldn't be loaded or copied
+} Result;
+
+static const char * enginename[] = { "switch", "threaded", "jit" };
+
+/*
+	Seconds on a monotonic clock.
+*/
+
+static double now ()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+	Whether engine e was built in.
+*/
+
+static int haveengine (Engine e)
+{
+#ifndef HAVE_THREADED
+	if (e == ENGINE_THREADED)
+	{
+		return 0;
+	}
+#endif
+#ifndef HAVE_JIT
+	if (e == ENGINE_JIT)
+	{
+		return 0;
+	}
+#endif
+	(void) e;
+	return 1;
+}
+
+/*
+	The child's side: loads the kernel and runs it on engine for secs
+	seconds, its output going to /dev/null and its input read from input
+	(or /dev/null) again on every run.
+*/
+
+static Result runkernel (const char * name, Engine engine, double secs, const char * input)
+{
+	Result r;
+	VM * prog = vmcreate();
+	VM * vm = vmcreate();
+	double start;
+
+	memset(&r, 0, sizeof(Result));
+	r.status = AOK;
+	if (prog == NULL || vm == NULL || vmloadfile(prog, name) != 0)
+	{
+		r.failed = 1;
+		return r;
+	}
+	prog->engine = engine;
+	vm->out = fopen("/dev/null", "w");
+	vm->in = fopen(input != NULL ? input : "/dev/null", "r");
+	if (vm->out == NULL || vm->in == NULL)
+	{
+		r.failed = 1;
+		return r;
+	}
+
+	start = now();
+	do
+	{
+		if (vmcopy(vm, prog) != 0)
+		{
+			r.failed = 1;
+			break;
+		}
+		rewind(vm->in);
+		vm->timeout = secs - (now() - start);
+		r.status = vmrun(vm);
+		r.runs++;
+	}
+	while (r.status == HLT && now() - start < secs);
+
+	r.secs = now() - start;
+	r.icount = vm->icount;
+	fflush(vm->out);
+	return r;
+}
+
+/*
+	Runs one kernel on one engine in a child and prints its line.
+	Returns 0, or -1 if it couldn't be run.
+*/
+
+static int bench (const char * name, Engine engine, double secs, const char * input)
+{
+	struct rusage usage;
+	Result r;
+	int fds[2];
+	int status;
+	pid_t pid;
+	ssize_t got = 0;
+
+	if (pipe(fds) != 0 || (pid = fork()) < 0)
+	{
+		fprintf(stderr, "ERROR: Could not start a run of %s\n", name);
+		return -1;
+	}
+	if (pid == 0)
+	{
+		close(fds[0]);
+		r = runkernel(name, engine, secs, input);
+		_exit(write(fds[1], &r, sizeof(Result)) == sizeof(Result) ? 0 : 1);
+	}
+
+	close(fds[1]);
+	do
+	{
+		got = read(fds[0], &r, sizeof(Result));
+	}
+	while (got < 0 && errno == EINTR);
+	close(fds[0]);
+	while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR)
+	{
+	}
+
+	if (got != sizeof(Result) || r.failed)
+	{
+		fprintf(stderr, "ERROR: Could not run %s\n", name);
+		return -1;
+	}
+	printf("%s\t%s\t%lld\t%lld\t%.3f\t%.0f\t%.3f\t%ld\t%s\n", name, enginename[engine], r.runs,
+		r.icount, r.secs, r.secs > 0 ? r.icount / r.secs : 0,
+		r.icount > 0 ? r.secs * 1e9 / r.icount : 0, usage.ru_maxrss, statusname(r.status));
+	fflush(stdout);
+	return 0;
+}
+
+int main (int argc, char ** argv)
+{
+	int engines[3] = { 0, 0, 0 };
+	double secs = 2;			//	Wall time of each kernel, -t
+	char * input = NULL;		//	Guest input of every run, -i
+	int failed = 0;
+	int opt, i, e, found;
+
+	while ((opt = getopt(argc, argv, "ht:e:i:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'h':
+				printf("Runs Y86 kernels for a fixed time each and prints their throughput.\n");
+				printf("Usage: \n");
+				printf("./y86bench [-t seconds] [-e engine] [-i input] <y86 or y86b file name>...\n");
+				printf("\t-t\tseconds to run each kernel on each engine, 2 by default\n");
+				printf("\t-e\tengine to run on, switch, threaded, jit or all, may be repeated; the default engine if left out\n");
+				printf("\t-i\tfile the kernels read as input, /dev/null by default\n");
+				printf("Prints kernel, engine, runs, instructions, seconds, ips, ns_per_insn, maxrss_kb and status\n");
+				printf("separated by tabs, one line per kernel and engine, e.g. ./y86bench -e all bench/*.y86\n");
+				return 0;
+
+			case 't':
+				secs = atof(optarg);
+			break;
+
+			case 'e':
+				found = 0;
+				for (e = 0; e < 3; e++)
+				{
+					if ((strcmp(optarg, "all") == 0 || strcmp(optarg, enginename[e]) == 0) && haveengine((Engine) e))
+					{
+						engines[e] = 1;
+						found = 1;
+					}
+				}
+				if (!found)
+				{
+					printf("ERROR: Unknown engine: %s\n", optarg);
+					return 0;
+				}
+			break;
+
+			case 'i':
+				input = optarg;
+			break;
+
+			default:
+				fprintf(stderr, "ERROR: Invalid option, see -h\n");
+				return 1;
+		}
+	}
+
+	if (optind >= argc)
+	{
+		printf("ERROR: Missing kernel file name, see -h\n");
+		return 0;
+	}
+	if (secs <= 0)
+	{
+		printf("ERROR: Invalid time: %g\n", secs);
+		return 0;
+	}
+	if (!engines[ENGINE_SWITCH] && !engines[ENGINE_THREADED] && !engines[ENGINE_JIT])
+	{
+		engines[DEFAULTENGINE] = 1;
+	}
+
+	printf("kernel\tengine\truns\tinstructions\tseconds\tips\tns_per_insn\tmaxrss_kb\tstatus\n");
+	for (i = optind; i < argc; i++)
+	{
+		for (e = 0; e < 3; e++)
+		{
+			if (engines[e] && bench(argv[i], (Engine) e, secs, input) != 0)
+			{
+				failed = 1;
+			}
+		}
+	}
+	return failed;
+}
@@ -0,0 +1,408 @@
+// Ryan Bandilla
+// Y86 Branch Predictors
+// BKR Comp Arch
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "y86branch.h"
+#include "y86disasm.h"
+
+static const char * kindname[] = { "btfn", "bimodal", "gshare", "ras" };
+
+/*
+	Parses one name[:n[:n]] of the spec into p.  Returns 0, or -1 if it
+	isn't one.
+*/
+
+static int parsepredictor (const char * text, Predictor * p)
+{
+	unsigned long v[2] = { 4096, 12 };
+	const char * colon = strchr(text, ':');
+	size_t len = colon != NULL ? (size_t) (colon - text) : strlen(text);
+	int i, n = 0;
+	char * end;
+
+	for (i = 0; i <= PREDICT_RAS; i++)
+	{
+		if (strlen(kindname[i]) == len && strncmp(text, kindname[i], len) == 0)
+		{
+			break;
+		}
+	}
+	if (i > PREDICT_RAS)
+	{
+		return -1;
+	}
+	p->kind = (PredictorKind) i;
+	if (p->kind == PREDICT_RAS)
+	{
+		v[0] = 16;
+	}
+
+	for (text += len; *text == ':' && n < 2; text = end)
+	{
+		v[n++] = strtoul(text + 1, &end, 10);
+		if (end == text + 1)
+		{
+			return -1;
+		}
+	}
+	if (*text != '\0' || (p->kind == PREDICT_BTFN && n > 0) || (p->kind != PREDICT_GSHARE && n > 1))
+	{
+		return -1;
+	}
+	if (v[0] == 0 || v[0] > (1ul << 24) || v[1] > 24 ||
+		(p->kind != PREDICT_RAS && (v[0] & (v[0] - 1)) != 0))
+	{
+		return -1;
+	}
+
+	p->entries = (unsigned int) v[0];
+	p->bits = (int) v[1];
+	switch (p->kind)
+	{
+		case PREDICT_BTFN:
+			snprintf(p->name, sizeof(p->name), "btfn");
+			break;
+		case PREDICT_GSHARE:
+			snprintf(p->name, sizeof(p->name), "gshare:%u:%d", p->entries, p->bits);
+			break;
+		default:
+			snprintf(p->name, sizeof(p->name), "%s:%u", kindname[p->kind], p->entries);
+			break;
+	}
+	return 0;
+}
+
+/*
+	Predictors of spec (see y86branch.h) for a program with memsize bytes
+	of memory.  Returns NULL if spec is invalid, with *badspec set, or
+	if there's no memory for them, with *badspec clear.
+*/
+
+BranchSim * branchcreate (const char * spec, unsigned int memsize, int * badspec)
+{
+	BranchSim * bs = (BranchSim *) calloc(1, sizeof(BranchSim));
+	char * copy = strdup(strcmp(spec, "default") == 0 ? BRANCHDEFAULT : spec);
+	char * item;
+	char * save = NULL;
+	int ok = bs != NULL && copy != NULL;
+
+	*badspec = 0;
+
+	for (item = ok ? strtok_r(copy, ",", &save) : NULL; item != NULL; item = strtok_r(NULL, ",", &save))
+	{
+		Predictor * p = &bs->predictors[bs->npredictors];
+
+		if (bs->npredictors == BRANCHMAX || parsepredictor(item, p) != 0)
+		{
+			*badspec = 1;
+			ok = 0;
+			break;
+		}
+		bs->npredictors++;
+
+		if (p->kind == PREDICT_RAS)
+		{
+			p->stack = (unsigned int *) calloc(p->entries, sizeof(unsigned int));
+			ok = p->stack != NULL;
+		}
+		else if (p->kind != PREDICT_BTFN)
+		{
+			// Weakly not taken to start with
+			p->counters = (unsigned char *) malloc(p->entries);
+			ok = p->counters != NULL;
+			if (ok)
+			{
+				memset(p->counters, 1, p->entries);
+			}
+		}
+		if (!ok)
+		{
+			break;
+		}
+	}
+	free(copy);
+
+	if (ok && bs->npredictors == 0)
+	{
+		*badspec = 1;
+		ok = 0;
+	}
+	if (ok && pctableinit(&bs->pcs, BRANCHWRONG + bs->npredictors) == 0)
+	{
+		bs->memsize = memsize;
+		return bs;
+	}
+	branchfree(bs);
+	return NULL;
+}
+
+/*
+	Releases the predictors.
+*/
+
+void branchfree (BranchSim * bs)
+{
+	int i;
+
+	if (bs != NULL)
+	{
+		for (i = 0; i < bs->npredictors; i++)
+		{
+			free(bs->predictors[i].counters);
+			free(bs->predictors[i].stack);
+		}
+		pctablefree(&bs->pcs);
+		free(bs);
+	}
+}
+
+/*
+	Counts the guess of predictor i, right or wrong, against the
+	counters of its pc, if it has them.
+*/
+
+static void score (BranchSim * bs, int i, long long * counts, int right)
+{
+	Predictor * p = &bs->predictors[i];
+
+	p->guesses++;
+	if (right)
+	{
+		p->correct++;
+	}
+	else if (counts != NULL)
+	{
+		counts[BRANCHWRONG + i]++;
+	}
+}
+
+/*
+	The counters of pc, or NULL if it is outside of memory or the table
+	is out of memory.
+*/
+
+static long long * pccounts (BranchSim * bs, unsigned int pc)
+{
+	return pc < bs->memsize ? pccounters(&bs->pcs, pc) : NULL;
+}
+
+/*
+	The conditional jump at pc to target, taken or not.  Every predictor
+	guesses before it learns the outcome.
+*/
+
+void branchcond (BranchSim * bs, unsigned int pc, int taken, unsigned int target)
+{
+	long long * counts = pccounts(bs, pc);
+	unsigned char * c;
+	int i;
+
+	bs->branches++;
+	bs->taken += taken != 0;
+	if (counts != NULL)
+	{
+		counts[BRANCHJUMPS]++;
+		counts[BRANCHTAKEN] += taken != 0;
+	}
+
+	for (i = 0; i < bs->npredictors; i++)
+	{
+		Predictor * p = &bs->predictors[i];
+
+		switch (p->kind)
+		{
+			case PREDICT_BTFN:
+				score(bs, i, counts, (target <= pc) == (taken != 0));
+				break;
+
+			case PREDICT_BIMODAL:
+			case PREDICT_GSHARE:
+				c = &p->counters[(pc ^ (p->kind == PREDICT_GSHARE ? p->history : 0)) & (p->entries - 1)];
+				score(bs, i, counts, (*c >= 2) == (taken != 0));
+				if (taken && *c < 3)
+				{
+					(*c)++;
+				}
+				else if (!taken && *c > 0)
+				{
+					(*c)--;
+				}
+				p->history = ((p->history << 1) | (taken != 0)) & ((1u << p->bits) - 1);
+				break;
+
+			case PREDICT_RAS:
+				break;
+		}
+	}
+}
+
+/*
+	A CALL returning to ret, pushed on every return address stack.
+*/
+
+void branchcall (BranchSim * bs, unsigned int ret)
+{
+	int i;
+
+	for (i = 0; i < bs->npredictors; i++)
+	{
+		Predictor * p = &bs->predictors[i];
+
+		if (p->kind == PREDICT_RAS)
+		{
+			p->stack[p->top++ % p->entries] = ret;
+			if (p->depth < p->entries)
+			{
+				p->depth++;
+			}
+		}
+	}
+}
+
+/*
+	The RET at pc, returning to to.  An empty stack has no guess and
+	counts as wrong.
+*/
+
+void branchret (BranchSim * bs, unsigned int pc, unsigned int to)
+{
+	long long * counts = pccounts(bs, pc);
+	int i;
+
+	bs->rets++;
+	if (counts != NULL)
+	{
+		counts[BRANCHRETS]++;
+	}
+
+	for (i = 0; i < bs->npredictors; i++)
+	{
+		Predictor * p = &bs->predictors[i];
+
+		if (p->kind != PREDICT_RAS)
+		{
+			continue;
+		}
+		if (p->depth == 0)
+		{
+			score(bs, i, counts, 0);
+			continue;
+		}
+		p->depth--;
+		score(bs, i, counts, p->stack[--p->top % p->entries] == to);
+	}
+}
+
+typedef struct
+{
+	unsigned int pc;
+	long long count;
+} BranchPc;
+
+static int morebranches (const void * a, const void * b)
+{
+	const BranchPc * x = (const BranchPc *) a;
+	const BranchPc * y = (const BranchPc *) b;
+
+	if (x->count != y->count)
+	{
+		return x->count < y->count ? 1 : -1;
+	}
+	return x->pc < y->pc ? -1 : x->pc > y->pc;
+}
+
+/*
+	Prints the accuracy of every predictor, then for the top pcs run
+	most often the accuracy of each predictor there, disassembled from
+	mem.  A pc counts as a jump and a RET for as many times as it ran
+	each, should the program have changed it.
+*/
+
+void branchreport (FILE * out, const BranchSim * bs, const unsigned char * mem, int top)
+{
+	size_t room = bs->pcs.npcs > 0 ? bs->pcs.npcs : 1;
+	BranchPc * pcs = (BranchPc *) malloc(room * sizeof(BranchPc));
+	unsigned int * at = (unsigned int *) malloc(room * sizeof(unsigned int));
+	unsigned int pc, n;
+	char text[64];
+	int i, k;
+
+	fprintf(out, "Branch prediction of %lld conditional jumps (%.1f%% taken) and %lld returns\n",
+		bs->branches, bs->branches > 0 ? 100.0 * bs->taken / bs->branches : 0, bs->rets);
+	fprintf(out, "\tpredictor                guesses        wrong  accuracy\n");
+	for (i = 0; i < bs->npredictors; i++)
+	{
+		const Predictor * p = &bs->predictors[i];
+
+		fprintf(out, "\t%-18s  %12lld %12lld   %6.2f%%\n", p->name, p->guesses, p->guesses - p->correct,
+			p->guesses > 0 ? 100.0 * p->correct / p->guesses : 0);
+	}
+
+	if (pcs == NULL || at == NULL)
+	{
+		free(pcs);
+		free(at);
+		return;
+	}
+	n = pctablepcs(&bs->pcs, at);
+	for (k = 0; k < (int) n; k++)
+	{
+		const long long * counts = pcfind(&bs->pcs, at[k]);
+
+		pcs[k].pc = at[k];
+		pcs[k].count = counts[BRANCHJUMPS] + counts[BRANCHRETS];
+	}
+	qsort(pcs, n, sizeof(BranchPc), morebranches);
+
+	fprintf(out, "\nAccuracy by pc:\n");
+	if (bs->pcs.failed)
+	{
+		fprintf(out, "\t(out of memory, some pcs are missing)\n");
+	}
+	fprintf(out, "\t          runs   taken");
+	for (i = 0; i < bs->npredictors; i++)
+	{
+		fprintf(out, "  %-*.*s", 16, 16, bs->predictors[i].name);
+	}
+	fprintf(out, "\n");
+
+	for (k = 0; k < (int) n && k < top; k++)
+	{
+		const long long * counts = pcfind(&bs->pcs, pcs[k].pc);
+		long long jumps = counts[BRANCHJUMPS];
+		long long rets = counts[BRANCHRETS];
+
+		pc = pcs[k].pc;
+		if (jumps == 0)
+		{
+			fprintf(out, "\t%14lld       -", pcs[k].count);
+		}
+		else
+		{
+			fprintf(out, "\t%14lld  %5.1f%%", pcs[k].count, 100.0 * counts[BRANCHTAKEN] / jumps);
+		}
+		for (i = 0; i < bs->npredictors; i++)
+		{
+			long long runs = bs->predictors[i].kind == PREDICT_RAS ? rets : jumps;
+
+			if (runs == 0)
+			{
+				strcpy(text, "-");
+			}
+			else
+			{
+				snprintf(text, sizeof(text), "%.2f%%", 100.0 * (runs - counts[BRANCHWRONG + i]) / runs);
+			}
+			fprintf(out, "  %-16s", text);
+		}
+		if (disasm(mem, bs->memsize, pc, text, sizeof(text)) == 0)
+		{
+			strcpy(text, "(invalid)");
+		}
+		fprintf(out, "  [0x%08x]\t%s\n", pc, text);
+	}
+	free(pcs);
+	free(at);
+}
@@ -0,0 +1,82 @@
+// Ryan Bandilla
+// Y86 Branch Predictors
+// BKR Comp Arch
+#ifndef Y86BRANCH_H
+#define Y86BRANCH_H
+
+#include <stdio.h>
+#include "y86pctable.h"
+
+/*
+ *	Branch predictors fed by the probes (y86probe.h), each guessing the
+ *	outcome of every conditional jump (71 to 76) or the target of every
+ *	RET before the run takes it.  They only watch, the run is the same
+ *	with any of them.
+ *
+ *	btfn                    - Static, backward jumps taken, forward ones not
+ *	bimodal[:entries]       - A 2 bit counter for each pc, entries of them
+ *	gshare[:entries[:bits]] - 2 bit counters indexed by the pc xor the
+ *	                          outcomes of the last bits jumps
+ *	ras[:depth]             - Return address stack, CALL pushes and RET
+ *	                          pops the guess, the oldest is lost when full
+ *
+ *	Several run side by side, given separated by commas, for example
+ *	"btfn,gshare:16384:14,ras:8".  entries must be a power of two,
+ *	left out it is 4096, bits 12 and depth 16.  "default" is
+ *	BRANCHDEFAULT.
+ */
+
+#define BRANCHDEFAULT "btfn,bimodal:4096,gshare:4096:12,ras:16"
+#define BRANCHMAX 8				//	Predictors in one run
+
+typedef enum
+{
+	PREDICT_BTFN,
+	PREDICT_BIMODAL,
+	PREDICT_GSHARE,
+	PREDICT_RAS
+} PredictorKind;
+
+typedef struct
+{
+	PredictorKind kind;
+	char name[32];				//	As given, with the defaults filled in
+	unsigned int entries;		//	Counters, or the depth of the stack
+	int bits;					//	History of gshare
+	unsigned char * counters;	//	0 and 1 predict not taken, 2 and 3 taken
+	unsigned int history;		//	Last outcomes, newest in bit 0
+	unsigned int * stack;		//	Return addresses, circular
+	unsigned int top;			//	Pushes less pops, to index the stack
+	unsigned int depth;			//	Return addresses held
+	long long guesses;
+	long long correct;
+} Predictor;
+
+/*
+ *	Counters of each pc in the table of a BranchSim.
+ */
+
+#define BRANCHJUMPS 0			//	Conditional jumps run there
+#define BRANCHTAKEN 1			//	Of those, taken
+#define BRANCHRETS 2			//	RETs run there
+#define BRANCHWRONG 3			//	Mispredictions of each predictor
+
+typedef struct
+{
+	unsigned int memsize;
+	Predictor predictors[BRANCHMAX];
+	int npredictors;
+	long long branches;			//	Conditional jumps run
+	long long taken;
+	long long rets;
+	PcTable pcs;				//	BRANCHJUMPS to BRANCHWRONG of each pc
+} BranchSim;
+
+BranchSim * branchcreate (const char * spec, unsigned int memsize, int * badspec);
+void branchfree (BranchSim * bs);
+void branchcond (BranchSim * bs, unsigned int pc, int taken, unsigned int target);
+void branchcall (BranchSim * bs, unsigned int ret);
+void branchret (BranchSim * bs, unsigned int pc, unsigned int to);
+void branchreport (FILE * out, const BranchSim * bs, const unsigned char * mem, int top);
+
+#endif
@@ -0,0 +1,468 @@
+// Ryan Bandilla
+// Y86 Cache Simulator
+// BKR Comp Arch
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "y86cache.h"
+#include "y86decode.h"
+#include "y86disasm.h"
+
+static const char * policyname[] = { "lru", "fifo", "random" };
+
+/*
+	Parses size:ways:line[:policy] into c.  Returns 0, or -1 if it isn't
+	one.
+*/
+
+static int parselevel (const char * text, CacheLevel * c)
+{
+	unsigned long long v[3];
+	char * end;
+	int i;
+
+	for (i = 0; i < 3; i++)
+	{
+		v[i] = strtoull(text, &end, 10);
+		if (end == text)
+		{
+			return -1;
+		}
+		if (i == 0 && (*end == 'k' || *end == 'K'))
+		{
+			v[i] <<= 10;
+			end++;
+		}
+		else if (i == 0 && (*end == 'm' || *end == 'M'))
+		{
+			v[i] <<= 20;
+			end++;
+		}
+		if (i == 0 && v[0] == 0 && *end == '\0')
+		{
+			c->size = 0;
+			return 0;
+		}
+		if (i < 2 && *end != ':')
+		{
+			return -1;
+		}
+		text = end + 1;
+	}
+	if (v[0] > 0x40000000ULL || v[1] > 0x10000 || v[2] > 0x10000)
+	{
+		return -1;
+	}
+
+	c->size = (unsigned int) v[0];
+	c->ways = (unsigned int) v[1];
+	c->line = (unsigned int) v[2];
+	c->policy = REPLACE_LRU;
+
+	if (*end == ':')
+	{
+		for (i = 0; i <= REPLACE_RANDOM; i++)
+		{
+			if (strcmp(end + 1, policyname[i]) == 0)
+			{
+				c->policy = (Replacement) i;
+				break;
+			}
+		}
+		if (i > REPLACE_RANDOM)
+		{
+			return -1;
+		}
+	}
+	else if (*end != '\0')
+	{
+		return -1;
+	}
+	return 0;
+}
+
+/*
+	Applies a comma separated list of name=size:ways:line[:policy] to the
+	levels.  Returns 0, or -1 if part of it can't be parsed.
+*/
+
+static int parsespec (CacheSim * cs, const char * spec)
+{
+	char * copy = strdup(spec);
+	char * item;
+	char * save = NULL;
+	int ok = copy != NULL;
+
+	for (item = ok ? strtok_r(copy, ",", &save) : NULL; item != NULL; item = strtok_r(NULL, ",", &save))
+	{
+		char * value = strchr(item, '=');
+		CacheLevel * c;
+
+		if (strcmp(item, "default") == 0)
+		{
+			continue;
+		}
+		if (value == NULL)
+		{
+			ok = 0;
+			break;
+		}
+		*value++ = '\0';
+
+		if (strcmp(item, "l1i") == 0)
+		{
+			c = &cs->l1i;
+		}
+		else if (strcmp(item, "l1d") == 0)
+		{
+			c = &cs->l1d;
+		}
+		else if (strcmp(item, "l2") == 0)
+		{
+			c = &cs->l2;
+		}
+		else
+		{
+			ok = 0;
+			break;
+		}
+
+		if (parselevel(value, c) != 0)
+		{
+			ok = 0;
+			break;
+		}
+	}
+	free(copy);
+	return ok ? 0 : -1;
+}
+
+/*
+	Checks the geometry of a level and gives it its lines.  Returns 0, or
+	-1 if the geometry is invalid, with *badspec set, or there's no
+	memory.
+*/
+
+static int levelinit (CacheLevel * c, const char * name, int * badspec)
+{
+	unsigned long long bytes;
+
+	c->name = name;
+	if (c->size == 0)
+	{
+		return 0;
+	}
+	if (c->ways == 0 || c->line < 4 || (c->line & (c->line - 1)) != 0)
+	{
+		*badspec = 1;
+		return -1;
+	}
+
+	bytes = (unsigned long long) c->ways * c->line;
+	c->sets = (unsigned int) (c->size / bytes);
+	if (c->sets == 0 || c->sets * bytes != c->size || (c->sets & (c->sets - 1)) != 0)
+	{
+		*badspec = 1;
+		return -1;
+	}
+	for (c->lineshift = 0; (1u << c->lineshift) < c->line; c->lineshift++)
+	{
+	}
+
+	c->lines = (CacheWay *) calloc((size_t) c->sets * c->ways, sizeof(CacheWay));
+	return c->lines != NULL ? 0 : -1;
+}
+
+/*
+	A hierarchy configured by spec (see y86cache.h) for a program with
+	memsize bytes of memory.  Returns NULL if spec is invalid, with
+	*badspec set, or if there's no memory for it, with *badspec clear.
+*/
+
+CacheSim * cachecreate (const char * spec, unsigned int memsize, int * badspec)
+{
+	CacheSim * cs = (CacheSim *) calloc(1, sizeof(CacheSim));
+
+	*badspec = 0;
+	if (cs == NULL)
+	{
+		return NULL;
+	}
+	if (parsespec(cs, CACHEDEFAULT) != 0 || parsespec(cs, spec) != 0)
+	{
+		*badspec = 1;
+		cachefree(cs);
+		return NULL;
+	}
+	if (levelinit(&cs->l1i, "L1I", badspec) != 0 || levelinit(&cs->l1d, "L1D", badspec) != 0 ||
+		levelinit(&cs->l2, "L2", badspec) != 0)
+	{
+		cachefree(cs);
+		return NULL;
+	}
+
+	cs->l1i.next = cs->l2.size > 0 ? &cs->l2 : NULL;
+	cs->l1d.next = cs->l1i.next;
+	cs->memsize = memsize;
+	cs->seed = 0x9e3779b97f4a7c15ULL;
+
+	if (pctableinit(&cs->misses, 2) != 0)
+	{
+		cachefree(cs);
+		return NULL;
+	}
+	return cs;
+}
+
+/*
+	Releases a hierarchy.
+*/
+
+void cachefree (CacheSim * cs)
+{
+	if (cs != NULL)
+	{
+		free(cs->l1i.lines);
+		free(cs->l1d.lines);
+		free(cs->l2.lines);
+		pctablefree(&cs->misses);
+		free(cs);
+	}
+}
+
+/*
+	Way of the set to fill on a miss: an empty one if there is one, or
+	the one the policy evicts.
+*/
+
+static CacheWay * victim (CacheSim * cs, CacheLevel * c, CacheWay * set)
+{
+	CacheWay * v = set;
+	unsigned int i;
+
+	for (i = 0; i < c->ways; i++)
+	{
+		if (!set[i].valid)
+		{
+			return &set[i];
+		}
+	}
+	if (c->policy == REPLACE_RANDOM)
+	{
+		cs->seed ^= cs->seed << 13;
+		cs->seed ^= cs->seed >> 7;
+		cs->seed ^= cs->seed << 17;
+		return &set[cs->seed % c->ways];
+	}
+	for (i = 1; i < c->ways; i++)
+	{
+		if (set[i].stamp < v->stamp)
+		{
+			v = &set[i];
+		}
+	}
+	return v;
+}
+
+/*
+	One load or store of the line holding addr at level c, and whatever
+	it takes from the levels below.
+*/
+
+static void levelaccess (CacheSim * cs, CacheLevel * c, unsigned long long addr, int write)
+{
+	unsigned long long tag;
+	CacheWay * set;
+	CacheWay * v;
+	long long * p;
+	unsigned int i;
+
+	if (c == NULL)
+	{
+		return;
+	}
+	if (c->lines == NULL)
+	{
+		levelaccess(cs, c->next, addr, write);
+		return;
+	}
+
+	tag = addr >> c->lineshift;
+	set = &c->lines[(size_t) (tag & (c->sets - 1)) * c->ways];
+	c->accesses[write]++;
+
+	for (i = 0; i < c->ways; i++)
+	{
+		if (set[i].valid && set[i].tag == tag)
+		{
+			if (c->policy == REPLACE_LRU)
+			{
+				set[i].stamp = ++cs->tick;
+			}
+			set[i].dirty |= write;
+			return;
+		}
+	}
+
+	c->misses[write]++;
+	if (cs->pc < cs->memsize && (p = pccounters(&cs->misses, cs->pc)) != NULL)
+	{
+		p[c == &cs->l2]++;
+	}
+
+	v = victim(cs, c, set);
+	if (v->valid && v->dirty)
+	{
+		c->writebacks++;
+		levelaccess(cs, c->next, v->tag << c->lineshift, 1);
+	}
+	levelaccess(cs, c->next, addr, 0);
+
+	v->tag = tag;
+	v->valid = 1;
+	v->dirty = (unsigned char) write;
+	v->stamp = ++cs->tick;
+}
+
+/*
+	An access of n bytes at addr from level c down, one per line it
+	touches.
+*/
+
+static void span (CacheSim * cs, CacheLevel * c, unsigned long long addr, int n, int write)
+{
+	unsigned long long line, last;
+
+	while (c != NULL && c->lines == NULL)
+	{
+		c = c->next;
+	}
+	if (c == NULL)
+	{
+		return;
+	}
+
+	last = (addr + n - 1) >> c->lineshift;
+	for (line = addr >> c->lineshift; line <= last; line++)
+	{
+		levelaccess(cs, c, line << c->lineshift, write);
+	}
+}
+
+/*
+	The fetch of the instruction at pc, whose first byte is op.  Misses
+	until the next fetch are charged to pc.
+*/
+
+void cachefetch (CacheSim * cs, unsigned int pc, unsigned char op)
+{
+	int n = instrlength(op);
+
+	cs->pc = pc;
+	span(cs, &cs->l1i, pc, n > 0 ? n : 1, 0);
+}
+
+/*
+	A load (write 0) or store (write 1) of n bytes at addr.
+*/
+
+void cachedata (CacheSim * cs, size_t addr, int n, int write)
+{
+	span(cs, &cs->l1d, addr, n, write);
+}
+
+/*
+	The totals of one level.
+*/
+
+static void levelreport (FILE * out, const CacheLevel * c)
+{
+	long long accesses = c->accesses[0] + c->accesses[1];
+	long long misses = c->misses[0] + c->misses[1];
+
+	if (c->lines == NULL)
+	{
+		fprintf(out, "\t%-4s  none\n", c->name);
+		return;
+	}
+	fprintf(out, "\t%-4s %10u %5u %5u  %-7s%14lld%14lld  %6.2f%%%14lld\n",
+		c->name, c->size, c->ways, c->line, policyname[c->policy],
+		accesses, misses, accesses > 0 ? 100.0 * misses / accesses : 0, c->writebacks);
+}
+
+typedef struct
+{
+	unsigned int pc;
+	long long l1misses;
+	long long l2misses;
+} MissPc;
+
+static int moremisses (const void * a, const void * b)
+{
+	const MissPc * x = (const MissPc *) a;
+	const MissPc * y = (const MissPc *) b;
+	long long xm = x->l1misses + x->l2misses;
+	long long ym = y->l1misses + y->l2misses;
+
+	if (xm != ym)
+	{
+		return xm < ym ? 1 : -1;
+	}
+	return x->pc < y->pc ? -1 : x->pc > y->pc;
+}
+
+/*
+	Prints the hit and miss counts of every level and the top pcs with
+	the most misses, disassembled from mem.
+*/
+
+void cachereport (FILE * out, const CacheSim * cs, const unsigned char * mem, int top)
+{
+	size_t room = cs->misses.npcs > 0 ? cs->misses.npcs : 1;
+	MissPc * pcs = (MissPc *) malloc(room * sizeof(MissPc));
+	unsigned int * at = (unsigned int *) malloc(room * sizeof(unsigned int));
+	unsigned int k, n;
+	char text[64];
+	int i;
+
+	fprintf(out, "Caches:\n");
+	fprintf(out, "\tlevel      size  ways  line  policy      accesses        misses   miss rate    writebacks\n");
+	levelreport(out, &cs->l1i);
+	levelreport(out, &cs->l1d);
+	levelreport(out, &cs->l2);
+
+	if (pcs == NULL || at == NULL)
+	{
+		free(pcs);
+		free(at);
+		return;
+	}
+	n = pctablepcs(&cs->misses, at);
+	for (k = 0; k < n; k++)
+	{
+		const long long * p = pcfind(&cs->misses, at[k]);
+
+		pcs[k].pc = at[k];
+		pcs[k].l1misses = p[0];
+		pcs[k].l2misses = p[1];
+	}
+	qsort(pcs, n, sizeof(MissPc), moremisses);
+
+	fprintf(out, "\nMisses by pc:\n");
+	if (cs->misses.failed)
+	{
+		fprintf(out, "\t(out of memory, some pcs are missing)\n");
+	}
+	fprintf(out, "\t     L1 misses     L2 misses\n");
+	for (i = 0; i < (int) n && i < top; i++)
+	{
+		if (disasm(mem, cs->memsize, pcs[i].pc, text, sizeof(text)) == 0)
+		{
+			strcpy(text, "(invalid)");
+		}
+		fprintf(out, "\t%14lld%14lld  [0x%08x]\t%s\n",
+			pcs[i].l1misses, pcs[i].l2misses, pcs[i].pc, text);
+	}
+	free(pcs);
+	free(at);
+}
@@ -0,0 +1,83 @@
+// Ryan Bandilla
+// Y86 Cache Simulator
+// BKR Comp Arch
+#ifndef Y86CACHE_H
+#define Y86CACHE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "y86pctable.h"
+
+/*
+ *	A two level cache hierarchy fed by the probes (y86probe.h): split L1
+ *	instruction and data caches in front of a unified L2.  Every
+ *	instruction fetch goes through L1I and every load and store through
+ *	L1D, a miss is filled from L2 and an L2 miss from memory.  The caches
+ *	are write back and write allocate, so a store is looked up like a
+ *	load and marks its line dirty, and a dirty line is written back to
+ *	the next level when it is evicted.
+ *
+ *	Each level is configured as name=size:ways:line[:policy], separated
+ *	by commas, for example
+ *
+ *		l1i=16k:4:32,l1d=16k:4:32:fifo,l2=256k:8:64:lru
+ *
+ *	size may end in k or m and is the total bytes of the level, line is
+ *	the bytes of a line, policy is lru (the default), fifo or random.
+ *	The number of sets, size / (ways * line), and line must be powers of
+ *	two.  A level given as 0 is left out.  Levels that aren't named keep
+ *	the defaults of CACHEDEFAULT, so "default" alone gives those.
+ */
+
+#define CACHEDEFAULT "l1i=32k:8:64:lru,l1d=32k:8:64:lru,l2=256k:8:64:lru"
+
+typedef enum
+{
+	REPLACE_LRU,		//	Least recently used
+	REPLACE_FIFO,		//	Oldest fill
+	REPLACE_RANDOM
+} Replacement;
+
+typedef struct
+{
+	unsigned long long tag;		//	Address >> line bits
+	unsigned long long stamp;	//	Last use (LRU) or fill (FIFO)
+	unsigned char valid;
+	unsigned char dirty;
+} CacheWay;
+
+typedef struct CacheLevel CacheLevel;
+
+struct CacheLevel
+{
+	const char * name;
+	unsigned int size;
+	unsigned int ways;
+	unsigned int line;
+	Replacement policy;
+	unsigned int sets;
+	int lineshift;
+	CacheWay * lines;			//	sets * ways
+	CacheLevel * next;			//	Where misses go, NULL for memory
+	long long accesses[2];		//	Loads and stores
+	long long misses[2];
+	long long writebacks;		//	Dirty lines evicted
+};
+
+typedef struct
+{
+	CacheLevel l1i, l1d, l2;
+	unsigned int memsize;
+	unsigned int pc;			//	Instruction running now
+	PcTable misses;				//	L1 and L2 misses of each pc (y86pctable.h)
+	unsigned long long tick;
+	unsigned long long seed;	//	Random replacement
+} CacheSim;
+
+CacheSim * cachecreate (const char * spec, unsigned int memsize, int * badspec);
+void cachefree (CacheSim * cs);
+void cachefetch (CacheSim * cs, unsigned int pc, unsigned char op);
+void cachedata (CacheSim * cs, size_t addr, int n, int write);
+void cachereport (FILE * out, const CacheSim * cs, const unsigned char * mem, int top);
+
+#endif
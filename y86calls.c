@@ -0,0 +1,293 @@
+// Ryan Bandilla
+// Y86 Call Graph Profiler
+// BKR Comp Arch
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "y86calls.h"
+
+/*
+	Totals of one function over every path it is on.
+*/
+
+typedef struct
+{
+	unsigned int func;
+	long long inclusive;		//	Instructions run while it was on the stack
+	long long exclusive;		//	Instructions run in it
+	long long calls;
+} CallFunc;
+
+/*
+	An empty call graph of a run starting at entry.
+	Returns NULL if there's no memory for it.
+*/
+
+CallGraph * callcreate (unsigned int entry)
+{
+	CallGraph * cg = (CallGraph *) calloc(1, sizeof(CallGraph));
+
+	if (cg == NULL)
+	{
+		return NULL;
+	}
+	cg->capnodes = 64;
+	if ((cg->nodes = (CallNode *) malloc(cg->capnodes * sizeof(CallNode))) == NULL)
+	{
+		free(cg);
+		return NULL;
+	}
+	cg->nnodes = 1;
+	cg->nodes[0].func = entry;
+	cg->nodes[0].parent = -1;
+	cg->nodes[0].child = -1;
+	cg->nodes[0].sibling = -1;
+	cg->nodes[0].self = 0;
+	cg->nodes[0].calls = 1;
+	return cg;
+}
+
+/*
+	Releases a call graph.
+*/
+
+void callfree (CallGraph * cg)
+{
+	if (cg != NULL)
+	{
+		free(cg->nodes);
+		free(cg);
+	}
+}
+
+/*
+	Node of the path from the current one into func, made if it's new.
+	Returns -1 if there's no memory for it.
+*/
+
+static int callchild (CallGraph * cg, unsigned int func)
+{
+	CallNode * node;
+	int n;
+
+	for (n = cg->nodes[cg->cur].child; n >= 0; n = cg->nodes[n].sibling)
+	{
+		if (cg->nodes[n].func == func)
+		{
+			return n;
+		}
+	}
+
+	if (cg->nnodes == cg->capnodes)
+	{
+		CallNode * grown = (CallNode *) realloc(cg->nodes, 2 * cg->capnodes * sizeof(CallNode));
+		if (grown == NULL)
+		{
+			return -1;
+		}
+		cg->nodes = grown;
+		cg->capnodes *= 2;
+	}
+
+	n = cg->nnodes++;
+	node = &cg->nodes[n];
+	node->func = func;
+	node->parent = cg->cur;
+	node->child = -1;
+	node->sibling = cg->nodes[cg->cur].child;
+	node->self = 0;
+	node->calls = 0;
+	cg->nodes[cg->cur].child = n;
+	return n;
+}
+
+/*
+	A CALL of func that will return to ret.
+*/
+
+void callenter (CallGraph * cg, unsigned int ret, unsigned int func)
+{
+	int n;
+
+	if (cg->overflow > 0 || cg->depth == CALLMAXDEPTH)
+	{
+		cg->overflow++;
+		return;
+	}
+	if ((n = callchild(cg, func)) < 0)
+	{
+		cg->failed = 1;
+		cg->overflow++;
+		return;
+	}
+
+	cg->nodes[n].calls++;
+	cg->frames[cg->depth] = n;
+	cg->rets[cg->depth] = ret;
+	cg->depth++;
+	cg->cur = n;
+}
+
+/*
+	A RET to the address to.
+*/
+
+void callreturn (CallGraph * cg, unsigned int to)
+{
+	int i;
+
+	if (cg->overflow > 0)
+	{
+		cg->overflow--;
+		return;
+	}
+	for (i = cg->depth - 1; i >= 0; i--)
+	{
+		if (cg->rets[i] == to)
+		{
+			cg->cur = cg->nodes[cg->frames[i]].parent;
+			cg->depth = i;
+			return;
+		}
+	}
+}
+
+/*
+	Writes every path that ran instructions as one line of folded stacks,
+	the functions from the entry point down separated by ';' and then the
+	count, the input of flamegraph.pl.
+*/
+
+void callfolded (FILE * out, const CallGraph * cg)
+{
+	int * path = (int *) malloc((CALLMAXDEPTH + 1) * sizeof(int));
+	int n, k, depth;
+
+	if (path == NULL)
+	{
+		return;
+	}
+	for (n = 0; n < cg->nnodes; n++)
+	{
+		if (cg->nodes[n].self == 0)
+		{
+			continue;
+		}
+		depth = 0;
+		for (k = n; k >= 0; k = cg->nodes[k].parent)
+		{
+			path[depth++] = k;
+		}
+		while (depth > 0)
+		{
+			depth--;
+			fprintf(out, "0x%x%c", cg->nodes[path[depth]].func, depth > 0 ? ';' : ' ');
+		}
+		fprintf(out, "%lld\n", cg->nodes[n].self);
+	}
+	free(path);
+}
+
+static int byfunc (const void * a, const void * b)
+{
+	const CallFunc * x = (const CallFunc *) a;
+	const CallFunc * y = (const CallFunc *) b;
+	return x->func < y->func ? -1 : x->func > y->func;
+}
+
+static int byinclusive (const void * a, const void * b)
+{
+	const CallFunc * x = (const CallFunc *) a;
+	const CallFunc * y = (const CallFunc *) b;
+
+	if (x->inclusive != y->inclusive)
+	{
+		return x->inclusive < y->inclusive ? 1 : -1;
+	}
+	return x->func < y->func ? -1 : x->func > y->func;
+}
+
+/*
+	Prints the top functions by inclusive count, with their exclusive
+	counts and calls.  A recursive function's inclusive count takes each
+	instruction once, however often it is on the stack.
+*/
+
+void callreport (FILE * out, const CallGraph * cg, int top)
+{
+	long long * total = (long long *) malloc(cg->nnodes * sizeof(long long));
+	CallFunc * funcs = (CallFunc *) malloc(cg->nnodes * sizeof(CallFunc));
+	int n, k, nfuncs;
+
+	if (total == NULL || funcs == NULL)
+	{
+		free(total);
+		free(funcs);
+		return;
+	}
+
+	// Callees are always made after their callers, so one pass from the
+	// end adds every subtree into its root
+	for (n = 0; n < cg->nnodes; n++)
+	{
+		total[n] = cg->nodes[n].self;
+	}
+	for (n = cg->nnodes - 1; n > 0; n--)
+	{
+		total[cg->nodes[n].parent] += total[n];
+	}
+
+	for (n = 0; n < cg->nnodes; n++)
+	{
+		const CallNode * node = &cg->nodes[n];
+
+		funcs[n].func = node->func;
+		funcs[n].exclusive = node->self;
+		funcs[n].calls = node->calls;
+		funcs[n].inclusive = total[n];
+
+		// Already counted by an outer call of the same function
+		for (k = node->parent; k >= 0; k = cg->nodes[k].parent)
+		{
+			if (cg->nodes[k].func == node->func)
+			{
+				funcs[n].inclusive = 0;
+				break;
+			}
+		}
+	}
+
+	qsort(funcs, cg->nnodes, sizeof(CallFunc), byfunc);
+	for (n = nfuncs = 0; n < cg->nnodes; n++)
+	{
+		if (nfuncs > 0 && funcs[nfuncs - 1].func == funcs[n].func)
+		{
+			funcs[nfuncs - 1].inclusive += funcs[n].inclusive;
+			funcs[nfuncs - 1].exclusive += funcs[n].exclusive;
+			funcs[nfuncs - 1].calls += funcs[n].calls;
+		}
+		else
+		{
+			funcs[nfuncs++] = funcs[n];
+		}
+	}
+	qsort(funcs, nfuncs, sizeof(CallFunc), byinclusive);
+
+	fprintf(out, "Call graph of %lld instructions, %d functions on %d paths\n",
+		total[0], nfuncs, cg->nnodes);
+	if (cg->failed)
+	{
+		fprintf(out, "Out of memory, some calls were missed\n");
+	}
+	fprintf(out, "\t     inclusive       %%     exclusive       %%         calls  function\n");
+	for (n = 0; n < nfuncs && n < top; n++)
+	{
+		fprintf(out, "\t%14lld  %5.1f%%%14lld  %5.1f%%%14lld  0x%08x\n",
+			funcs[n].inclusive, total[0] > 0 ? 100.0 * funcs[n].inclusive / total[0] : 0,
+			funcs[n].exclusive, total[0] > 0 ? 100.0 * funcs[n].exclusive / total[0] : 0,
+			funcs[n].calls, funcs[n].func);
+	}
+
+	free(total);
+	free(funcs);
+}
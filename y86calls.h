@@ -0,0 +1,61 @@
+// Ryan Bandilla
+// Y86 Call Graph Profiler
+// BKR Comp Arch
+#ifndef Y86CALLS_H
+#define Y86CALLS_H
+
+#include <stdio.h>
+
+/*
+ *	Instructions counted by call path.  A shadow of the guest's call stack
+ *	follows CALL and RET, and each path from the entry point down to the
+ *	function running now is a node of a tree; an instruction counts
+ *	against the node of the path it ran on.  Functions are named by the
+ *	address they were called at, the entry point by the pc the run
+ *	started at.
+ *
+ *	A RET pops the shadow stack down to the frame it returns from, found
+ *	by its return address, so code that unwinds several frames at once
+ *	stays in step.  A RET to no address on the stack is taken as a jump
+ *	and leaves it alone.  Calls deeper than CALLMAXDEPTH count against
+ *	the deepest path.
+ */
+
+#define CALLMAXDEPTH 4096
+
+typedef struct
+{
+	unsigned int func;			//	Address the function was called at
+	int parent;					//	Node of the caller, -1 for the entry point
+	int child;					//	First callee, -1 for none
+	int sibling;				//	Next callee of the parent, -1 for none
+	long long self;				//	Instructions run on exactly this path
+	long long calls;			//	Times this path was entered
+} CallNode;
+
+typedef struct
+{
+	CallNode * nodes;
+	int nnodes;
+	int capnodes;
+	int cur;					//	Node of the function running now
+	int depth;					//	Frames on the shadow stack
+	int overflow;				//	Calls past CALLMAXDEPTH not yet returned
+	int failed;					//	Out of memory, later calls are missed
+	int frames[CALLMAXDEPTH];	//	Node of each frame
+	unsigned int rets[CALLMAXDEPTH];	//	Return address of each frame
+} CallGraph;
+
+CallGraph * callcreate (unsigned int entry);
+void callfree (CallGraph * cg);
+void callenter (CallGraph * cg, unsigned int ret, unsigned int func);
+void callreturn (CallGraph * cg, unsigned int to);
+void callfolded (FILE * out, const CallGraph * cg);
+void callreport (FILE * out, const CallGraph * cg, int top);
+
+static inline void callinsn (CallGraph * cg)
+{
+	cg->nodes[cg->cur].self++;
+}
+
+#endif
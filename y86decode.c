@@ -0,0 +1,180 @@
+// Ryan Bandilla
+// Y86 Decode Cache
+// BKR Comp Arch
+#include <string.h>
+#include "y86decode.h"
+#include "y86mem.h"
+
+/*
+	Handler and length of every opcode, opcodes left out are invalid.
+*/
+
+static const struct { unsigned char handler; unsigned char len; } opcodes[256] =
+{
+	[0x00] = { H_NOP, 1 },
+	[0x10] = { H_HALT, 1 },
+	[0x20] = { H_RRMOVL, 2 },
+	[0x30] = { H_IRMOVL, 6 },
+	[0x40] = { H_RMMOVL, 6 },
+	[0x50] = { H_MRMOVL, 6 },
+	[0x60] = { H_ADDL, 2 },
+	[0x61] = { H_SUBL, 2 },
+	[0x62] = { H_ANDL, 2 },
+	[0x63] = { H_XORL, 2 },
+	[0x64] = { H_MULL, 2 },
+	[0x65] = { H_CMPL, 2 },
+	[0x70] = { H_JMP, 5 },
+	[0x71] = { H_JLE, 5 },
+	[0x72] = { H_JL, 5 },
+	[0x73] = { H_JE, 5 },
+	[0x74] = { H_JNE, 5 },
+	[0x75] = { H_JGE, 5 },
+	[0x76] = { H_JG, 5 },
+	[0x80] = { H_CALL, 5 },
+	[0x90] = { H_RET, 1 },
+	[0xA0] = { H_PUSHL, 2 },
+	[0xB0] = { H_POPL, 2 },
+	[0xC0] = { H_READB, 6 },
+	[0xC1] = { H_READL, 6 },
+	[0xD0] = { H_WRITEB, 6 },
+	[0xD1] = { H_WRITEL, 6 },
+	[0xE0] = { H_MOVSBL, 6 }
+};
+
+/*
+	Length of the instruction with the given opcode, 0 if it isn't one.
+*/
+
+int instrlength (unsigned char op)
+{
+	return opcodes[op].len;
+}
+
+/*
+	Sets up an empty cache for size bytes of memory.
+	The tables are demand-zero memory, so only the pages holding code
+	that actually runs are ever touched.
+	Returns 0 on success and -1 if the tables can't be mapped.
+*/
+
+int dcacheinit (DecodeCache * dc, unsigned int size)
+{
+	memset(dc, 0, sizeof(DecodeCache));
+
+	dc->entries = (Decoded *) memalloc((size_t) size * sizeof(Decoded), 1);
+	dc->code = memalloc((size_t) size + 4, 1);
+	dc->size = size;
+	dc->codestart = size;
+
+	if (dc->entries == NULL || dc->code == NULL)
+	{
+		dcachefree(dc);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+	Releases the tables of a cache.  The counters are kept so they can be
+	reported after the run.
+*/
+
+void dcachefree (DecodeCache * dc)
+{
+	if (dc->entries != NULL)
+	{
+		memfree((unsigned char *) dc->entries, (size_t) dc->size * sizeof(Decoded));
+	}
+	if (dc->code != NULL)
+	{
+		memfree(dc->code, (size_t) dc->size + 4);
+	}
+	dc->entries = NULL;
+	dc->code = NULL;
+	dc->size = 0;
+}
+
+/*
+	Decodes the instruction at pc into its cache entry.
+	An invalid opcode decodes as a one byte instruction so the interpreter
+	can report it.  Returns NULL if pc or the end of the instruction is
+	outside of memory.
+*/
+
+Decoded * dcachefill (DecodeCache * dc, const unsigned char * mem, int pc)
+{
+	unsigned int at = (unsigned int) pc;
+	unsigned char op;
+	unsigned int len;
+
+	if (at >= dc->size)
+	{
+		return NULL;
+	}
+
+	op = mem[at];
+	len = instrlength(op);
+
+	if (len == 0)
+	{
+		len = 1;
+	}
+	if (at + len > dc->size)
+	{
+		return NULL;
+	}
+
+	Decoded * d = &dc->entries[at];
+	d->handler = opcodes[op].len != 0 ? opcodes[op].handler : H_INVALID;
+	d->ra = len > 1 ? (mem[at + 1] & 0xf0) >> 4 : 0;
+	d->rb = len > 1 ? (mem[at + 1] & 0x0f) : 0;
+	d->imm = 0;
+
+	//	Little endian immediate, after the opcode for jumps and calls and
+	//	after the register byte for everything else
+	if (len == 5)
+	{
+		d->imm = load32(mem + at + 1);
+	}
+	else if (len == 6)
+	{
+		d->imm = load32(mem + at + 2);
+	}
+
+	d->len = len;
+	memset(dc->code + at, 1, len);
+	if (at < dc->codestart)
+	{
+		dc->codestart = at;
+	}
+	if (at + len > dc->codeend)
+	{
+		dc->codeend = at + len;
+	}
+	dc->decodes++;
+	return d;
+}
+
+/*
+	Drops every decoded instruction that overlaps the n bytes at addr.
+	The code marks are left alone: other entries may still cover those
+	bytes and a spare mark only costs an extra check on a later store.
+*/
+
+void dcacheinvalidate (DecodeCache * dc, unsigned int addr, unsigned int n)
+{
+	unsigned int first = addr >= 5 ? addr - 5 : 0;
+	unsigned int k;
+
+	dc->codewrites++;
+	dc->lastwrite = addr;
+
+	for (k = first; k < addr + n && k < dc->size; k++)
+	{
+		if (dc->entries[k].handler != H_DECODE && k + dc->entries[k].len > addr)
+		{
+			dc->entries[k].handler = H_DECODE;
+			dc->invalidations++;
+		}
+	}
+}
@@ -0,0 +1,98 @@
+// Ryan Bandilla
+// Y86 Decode Cache
+// BKR Comp Arch
+#ifndef Y86DECODE_H
+#define Y86DECODE_H
+
+#include <string.h>
+
+/*
+ *	What run() does with a decoded instruction.  An entry that
+ *	hasn't been decoded yet is all zero, so its handler is H_DECODE.
+ */
+
+typedef enum
+{
+	H_DECODE,
+	H_NOP, H_HALT, H_RRMOVL, H_IRMOVL, H_RMMOVL, H_MRMOVL,
+	H_ADDL, H_SUBL, H_ANDL, H_XORL, H_MULL, H_CMPL,
+	H_JMP, H_JLE, H_JL, H_JE, H_JNE, H_JGE, H_JG,
+	H_CALL, H_RET, H_PUSHL, H_POPL,
+	H_READB, H_READL, H_WRITEB, H_WRITEL, H_MOVSBL,
+	H_INVALID
+} Handler;
+
+/*
+ *	An instruction decoded once so executing it again doesn't need to
+ *	look at its bytes.
+ *
+ *	handler - Handler for the opcode byte
+ *	ra      - High nibble of the register byte
+ *	rb      - Low nibble of the register byte
+ *	len     - Length in bytes
+ *	imm     - 32 bit immediate, displacement or destination
+ */
+
+typedef struct
+{
+	unsigned char handler;
+	unsigned char ra;
+	unsigned char rb;
+	unsigned char len;
+	int imm;
+} Decoded;
+
+/*
+ *	Decoded instructions for every address of memory, filled in lazily the
+ *	first time each pc is executed.  code marks the bytes covered by a
+ *	decoded instruction so a store into them can throw the stale entries
+ *	away.
+ */
+
+typedef struct
+{
+	Decoded * entries;
+	unsigned char * code;
+	unsigned int size;
+	long long decodes;
+	long long invalidations;
+	long long codewrites;		//	Stores into marked bytes
+	unsigned int lastwrite;		//	Address of the last of them
+	unsigned int codestart;		//	The marked bytes all lie from codestart
+	unsigned int codeend;		//	up to codeend
+} DecodeCache;
+
+int instrlength (unsigned char op);
+int dcacheinit (DecodeCache * dc, unsigned int size);
+void dcachefree (DecodeCache * dc);
+Decoded * dcachefill (DecodeCache * dc, const unsigned char * mem, int pc);
+void dcacheinvalidate (DecodeCache * dc, unsigned int addr, unsigned int n);
+
+/*
+	Called before n bytes at addr are stored to (n is 1 or 4).
+	Stores outside of decoded code cost one load and a compare.
+*/
+
+static inline void dcachewrite (DecodeCache * dc, unsigned int addr, unsigned int n)
+{
+	unsigned int mark;
+
+	if (addr >= dc->size)
+	{
+		return;
+	}
+	if (n == 4)
+	{
+		memcpy(&mark, dc->code + addr, 4);
+	}
+	else
+	{
+		mark = dc->code[addr];
+	}
+	if (mark != 0)
+	{
+		dcacheinvalidate(dc, addr, n);
+	}
+}
+
+#endif
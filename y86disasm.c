@@ -0,0 +1,150 @@
+// Ryan Bandilla
+// Y86 Disassembler
+// BKR Comp Arch
+#include <stdio.h>
+#include "y86disasm.h"
+#include "y86decode.h"
+#include "y86mem.h"
+
+/*
+	Strings representing the register corresponding to its associated
+	encoding.  8 to 15 aren't registers.
+*/
+
+static const char * regname[16] =
+{
+	"%eax", "%ecx", "%edx", "%ebx", "%esp", "%ebp", "%esi", "%edi",
+	"%r?", "%r?", "%r?", "%r?", "%r?", "%r?", "%r?", "%r?"
+};
+
+/*
+	Mnemonic of an opcode, or NULL if it isn't an instruction.
+*/
+
+const char * disname (unsigned char op)
+{
+	switch (op)
+	{
+		case 0x00: return "nop";
+		case 0x10: return "hlt";
+		case 0x20: return "rrmovl";
+		case 0x30: return "irmovl";
+		case 0x40: return "rmmovl";
+		case 0x50: return "mrmovl";
+		case 0x60: return "addl";
+		case 0x61: return "subl";
+		case 0x62: return "andl";
+		case 0x63: return "xorl";
+		case 0x64: return "mull";
+		case 0x65: return "cmpl";
+		case 0x70: return "jmp";
+		case 0x71: return "jle";
+		case 0x72: return "jl";
+		case 0x73: return "je";
+		case 0x74: return "jne";
+		case 0x75: return "jge";
+		case 0x76: return "jg";
+		case 0x80: return "call";
+		case 0x90: return "ret";
+		case 0xA0: return "pushl";
+		case 0xB0: return "popl";
+		case 0xC0: return "readb";
+		case 0xC1: return "readl";
+		case 0xD0: return "writeb";
+		case 0xD1: return "writel";
+		case 0xE0: return "movsbl";
+	}
+	return NULL;
+}
+
+/*
+	Writes the instruction at address at of the size bytes of mem into
+	text, at most len bytes with the '\0'.
+	Returns its length in bytes, or 0 if there is no instruction there or
+	it runs past the end of mem.
+*/
+
+int disasm (const unsigned char * mem, unsigned int size, unsigned int at, char * text, size_t len)
+{
+	const char * name;
+	const char * ra;
+	const char * rb;
+	unsigned char op;
+	int n, value = 0;
+
+	if (at >= size)
+	{
+		return 0;
+	}
+	op = mem[at];
+	n = instrlength(op);
+	if ((name = disname(op)) == NULL || n == 0 || (unsigned long long) at + n > size)
+	{
+		return 0;
+	}
+
+	ra = n > 1 ? regname[mem[at + 1] >> 4] : "";
+	rb = n > 1 ? regname[mem[at + 1] & 0x0f] : "";
+	if (n == 5)
+	{
+		value = load32(mem + at + 1);
+	}
+	else if (n == 6)
+	{
+		value = load32(mem + at + 2);
+	}
+
+	switch (op)
+	{
+		case 0x20:
+		case 0x60:
+		case 0x61:
+		case 0x62:
+		case 0x63:
+		case 0x64:
+		case 0x65:
+			snprintf(text, len, "%s\t%s\t%s", name, ra, rb);
+		break;
+
+		case 0x30:
+			snprintf(text, len, "%s\t$%0x\t%s", name, value, rb);
+		break;
+
+		case 0x40:
+			snprintf(text, len, "%s\t%s\t%d%s", name, ra, value, rb);
+		break;
+
+		case 0x50:
+		case 0xE0:
+			snprintf(text, len, "%s\t%d%s\t%s", name, value, rb, ra);
+		break;
+
+		case 0x70:
+		case 0x71:
+		case 0x72:
+		case 0x73:
+		case 0x74:
+		case 0x75:
+		case 0x76:
+		case 0x80:
+			snprintf(text, len, "%s\t$0x%x", name, value);
+		break;
+
+		case 0xA0:
+		case 0xB0:
+			snprintf(text, len, "%s\t%s", name, ra);
+		break;
+
+		case 0xC0:
+		case 0xC1:
+		case 0xD0:
+		case 0xD1:
+			snprintf(text, len, "%s\t%d%s", name, value, ra);
+		break;
+
+		default:
+			snprintf(text, len, "%s", name);
+		break;
+	}
+	return n;
+}
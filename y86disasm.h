@@ -0,0 +1,17 @@
+// Ryan Bandilla
+// Y86 Disassembler
+// BKR Comp Arch
+#ifndef Y86DISASM_H
+#define Y86DISASM_H
+
+#include <stddef.h>
+
+/*
+ *	One instruction as y86dis prints it, without the address: the
+ *	mnemonic, then the operands separated by tabs.
+ */
+
+const char * disname (unsigned char op);
+int disasm (const unsigned char * mem, unsigned int size, unsigned int at, char * text, size_t len);
+
+#endif
@@ -0,0 +1,199 @@
+// Ryan Bandilla
+// Y86 Memory Dumps
+// BKR Comp Arch
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "y86dump.h"
+#include "y86image.h"
+
+#define DUMPCHUNK (1 << 20)		//	Bytes of text formatted before each write
+#define DUMPLINE 16				//	Bytes on a line of DUMP_NONZERO
+
+/*
+	"%x " of every byte value, padded to four bytes so each one is copied
+	with a single move, and the length that counts.
+*/
+
+static char hextext[256][4];
+static unsigned char hexlen[256];
+
+static void hexinit ()
+{
+	static const char digits[] = "0123456789abcdef";
+	int c;
+
+	if (hexlen[0] != 0)
+	{
+		return;
+	}
+	for (c = 0; c < 256; c++)
+	{
+		char * t = hextext[c];
+
+		if (c < 16)
+		{
+			t[0] = digits[c];
+			t[1] = ' ';
+			hexlen[c] = 2;
+		}
+		else
+		{
+			t[0] = digits[c >> 4];
+			t[1] = digits[c & 15];
+			t[2] = ' ';
+			hexlen[c] = 3;
+		}
+	}
+}
+
+/*
+	Writes every byte as printf("%x ") would, a chunk at a time through a
+	buffer, so a large memory is a handful of writes instead of a printf
+	per byte.  Up to DUMPCHUNK bytes it is a single write.  Larger memory
+	isn't formatted into one buffer of its own: the text is up to three
+	times the .size, which for a sparse program of a few GiB would cost
+	more than the dump, and one write per MiB is already cheap.
+*/
+
+static void dumphex (FILE * out, const unsigned char * mem, unsigned int size)
+{
+	char * buf = (char *) malloc(3 * DUMPCHUNK + 4);
+	unsigned int i = 0;
+
+	hexinit();
+	if (buf == NULL)
+	{
+		for (i = 0; i < size; i++)
+		{
+			fprintf(out, "%x ", mem[i]);
+		}
+		fputc('\n', out);
+		return;
+	}
+
+	while (i < size)
+	{
+		unsigned int end = size - i > DUMPCHUNK ? i + DUMPCHUNK : size;
+		char * p = buf;
+
+		for (; i < end; i++)
+		{
+			memcpy(p, hextext[mem[i]], 4);
+			p += hexlen[mem[i]];
+		}
+		if (i == size)
+		{
+			*p++ = '\n';
+		}
+		fwrite(buf, 1, p - buf, out);
+	}
+	if (size == 0)
+	{
+		fputc('\n', out);
+	}
+	free(buf);
+}
+
+/*
+	Whether the n bytes at p are all zero, a word at a time.
+*/
+
+static int allzero (const unsigned char * p, unsigned int n)
+{
+	unsigned int i = 0;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		unsigned long long word;
+		memcpy(&word, p + i, 8);
+		if (word != 0)
+		{
+			return 0;
+		}
+	}
+	for (; i < n; i++)
+	{
+		if (p[i] != 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+	Writes the lines of DUMPLINE bytes that hold anything, each as its
+	address and the bytes in two digit hex.
+*/
+
+static void dumpnonzero (FILE * out, const unsigned char * mem, unsigned int size)
+{
+	unsigned int addr, i;
+
+	for (addr = 0; addr < size; addr += DUMPLINE)
+	{
+		unsigned int n = size - addr < DUMPLINE ? size - addr : DUMPLINE;
+
+		if (allzero(mem + addr, n))
+		{
+			continue;
+		}
+		fprintf(out, "%08x:", addr);
+		for (i = 0; i < n; i++)
+		{
+			fprintf(out, " %02x", mem[addr + i]);
+		}
+		fputc('\n', out);
+	}
+}
+
+/*
+	Finds the mode called name, as given to -x.  Returns 0, or -1 if
+	there is none.
+*/
+
+int dumpmode (const char * name, DumpMode * mode)
+{
+	static const char * names[] = { "hex", "raw", "nonzero", "hash", "none" };
+	int i;
+
+	for (i = 0; i <= DUMP_NONE; i++)
+	{
+		if (strcmp(name, names[i]) == 0)
+		{
+			*mode = (DumpMode) i;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/*
+	Writes the size bytes of memory at mem to out in the given mode.
+*/
+
+void dumpmemory (FILE * out, const unsigned char * mem, unsigned int size, DumpMode mode)
+{
+	switch (mode)
+	{
+		case DUMP_HEX:
+			dumphex(out, mem, size);
+		break;
+
+		case DUMP_RAW:
+			fwrite(mem, 1, size, out);
+		break;
+
+		case DUMP_NONZERO:
+			dumpnonzero(out, mem, size);
+		break;
+
+		case DUMP_HASH:
+			fprintf(out, "%016llx\n", hashbytes(mem, size));
+		break;
+
+		case DUMP_NONE:
+		break;
+	}
+}
@@ -0,0 +1,33 @@
+// Ryan Bandilla
+// Y86 Memory Dumps
+// BKR Comp Arch
+#ifndef Y86DUMP_H
+#define Y86DUMP_H
+
+#include <stdio.h>
+
+/*
+ *	What is printed of guest memory after a run
+ *
+ *	DUMP_HEX     - Every byte as "%x ", then a newline (printmemory())
+ *	DUMP_RAW     - The bytes themselves
+ *	DUMP_NONZERO - Lines of 16 bytes with their address, only those that
+ *	               aren't all zero.  Nothing records which memory a run
+ *	               wrote, so every line of it is scanned
+ *	DUMP_HASH    - hashbytes() of the memory, to compare runs cheaply
+ *	DUMP_NONE    - Nothing
+ */
+
+typedef enum
+{
+	DUMP_HEX,
+	DUMP_RAW,
+	DUMP_NONZERO,
+	DUMP_HASH,
+	DUMP_NONE
+} DumpMode;
+
+int dumpmode (const char * name, DumpMode * mode);
+void dumpmemory (FILE * out, const unsigned char * mem, unsigned int size, DumpMode mode);
+
+#endif
@@ -3,1242 +3,597 @@
 // BKR Comp Arch
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
 #include <malloc.h>
 #include "y86emul.h"
-#include <math.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include "y86load.h"
+#include "y86image.h"
+#include "y86mem.h"
+#include "y86batch.h"
+#include "y86fork.h"
+#include "y86dump.h"
+#include "y86probe.h"
 
-int reg[8];
+int main (int argc, char ** argv)
+{
+	int showstats = 0;
+	int showmemory = 0;
+	int noreserve = 0;
+	int guard = 0;
+	int serve = 0;				//	Fork server, -f
+	DumpMode dump = DUMP_HEX;	//	Memory printed after the run, -x
+	int profile = 0;			//	Print a profile of the run, -p
+	char * foldedname = NULL;	//	File for the folded call stacks, -F
+	char * cachespec = NULL;	//	Cache hierarchy to simulate, -C
+	int pipeline = 0;			//	Model the run on PIPE, -P
+	char * branchspec = NULL;	//	Branch predictors to simulate, -B
+	Engine engine = DEFAULTENGINE;
+	char * outname = NULL;		//	Image to write instead of running, -o
+	char * cachedir = NULL;		//	Directory of cached images, -c
+	char * batchpath = NULL;	//	Inputs to run the program on, -b
+	char * batchout = NULL;		//	Directory for the outputs of the runs, -d
+	int threads = 0;			//	Threads for the batch, 0 for every core
+	long long budget = 0;		//	Instructions a run may execute, -l
+	double timeout = 0;			//	Seconds a run may take, -t
+	int opt;
 
-/*
- *	Registers to be used by the program
- *	reg[0] == %eax
- *	reg[1] == %ecx
- *	reg[2] == %edx
- *	reg[3] == %ebx
- *	reg[4] == %esp
- *	reg[5] == %ebp
- *	reg[6] == %esi
- *	reg[7] == %edi
- */
-
-int pc;
+//	Checks for the help flag and prints the usage of this program
 
-/*
- *	Program counter
- *	Points to memory where the instruction being executed exists
- *	Will be initialized as a part of processing the .text directive
- *	Will be used as an offset from the starting location of the instructions in memory.
- */
+	while ((opt = getopt(argc, argv, "hsmngfpPo:c:e:b:j:d:l:t:x:F:C:B:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'h':
+				printf("This emulator can be used to run programs written in Y86 instructions.\n");
+				printf("Usage: \n");
+				printf("./y86emul [-smngpP] [-e engine] [-l instructions] [-t seconds] [-x dump] [-F folded] [-C caches] [-B predictors] [-o image] [-c cachedir] <y86 or y86b file name>\n");
+				printf("./y86emul -b inputs [-j threads] [-d outdir] [-sn] [-l instructions] [-t seconds] [-c cachedir] <y86 or y86b file name>\n");
+				printf("./y86emul -f [-sng] [-e engine] [-l instructions] [-t seconds] [-c cachedir] <y86 or y86b file name>\n");
+				printf("\t-s\tprint load and execution statistics to stderr\n");
+				printf("\t-m\tprint resident memory to stderr at exit\n");
+				printf("\t-n\tdon't reserve swap for the whole .size (MAP_NORESERVE)\n");
+				printf("\t-g\trun in guarded memory, any access outside of .size stops with ADR\n");
+				printf("\t-p\tprint the hottest instructions, opcodes and memory of the run to stderr\n");
+				printf("\t-F\twrite the run's call stacks to folded for flamegraph.pl, and print the call graph to stderr\n");
+				printf("\t-C\tsimulate caches, e.g. default or l1i=32k:8:64,l1d=32k:8:64:lru,l2=256k:8:64, and print their misses to stderr\n");
+				printf("\t-P\tmodel the run on a five stage pipeline and print its CPI and stalls to stderr\n");
+				printf("\t-B\tsimulate branch predictors, e.g. default or btfn,bimodal:4096,gshare:4096:12,ras:16, and print their accuracy to stderr\n");
+				printf("\t-l\tstop with TMO after about this many instructions\n");
+				printf("\t-t\tstop with TMO after about this many seconds\n");
+				printf("\t-x\tmemory printed after the run, hex (the default), raw, nonzero (lines that aren't all zero, found by scanning all of memory), hash or none\n");
+				printf("\t-o\twrite the loaded program to a .y86b image instead of running it\n");
+				printf("\t-c\tkeep .y86b images of .y86 files in cachedir and reuse them\n");
+				printf("\t-e\tdispatch engine, switch, threaded (the default) or jit\n");
+				printf("\t-b\trun the program once per input, a directory of them or a file listing them, in guarded memory\n");
+				printf("\t-j\tthreads to run a batch on, one per core by default\n");
+				printf("\t-d\twrite the output of each run of a batch to outdir/<input name>.out\n");
+				printf("\t-f\tfork server, run the program on each input named on a line of stdin\n");
+				return 0;
 
-unsigned char * memspace;
+			case 's':
+				showstats = 1;
+			break;
 
-/*
- *	Contiguous block of memory where all instructions and data for program 
- *	exectution will be stored.
- *	Will be initialiezed as a part of processing the .size directive
- */
+			case 'm':
+				showmemory = 1;
+			break;
 
- int memsize;
+			case 'n':
+				noreserve = 1;
+			break;
 
- /*
-  * Stores the length of the chunk of memory
-  */
+			case 'g':
+				guard = 1;
+			break;
 
-int OF, ZF, SF;
+			case 'f':
+				serve = 1;
+			break;
 
-/*
- *	DEFAULT STATE is 0
- *	ACTIVATED STATE is 1
- *	OF Overflow flag
- *	ZF Zero Flag
- *	SF Negative Flag
- */
+			case 'p':
+				profile = 1;
+			break;
 
-ProgramStatus status = AOK;
+			case 'P':
+				pipeline = 1;
+			break;
 
-/*
- *	Current status of program execution.
- *	Default is AOK and if no errors are found during exectution program status will remain AOK
- *
- *	Possible States:
- *
- *	AOK - No errors detected from start to current position
- *	HLT - Halt program execution
- *	ADR - Program encountered an invalid or bad address
- *	INS - Invalid instruction encountered
- *	
- *	If the program enters either the HLT, ADR, or INS state
- *	execution will cease and the program will exit
- */
+			case 'B':
+				branchspec = optarg;
+			break;
+
+			case 'F':
+				foldedname = optarg;
+			break;
+
+			case 'C':
+				cachespec = optarg;
+			break;
+
+			case 'l':
+				budget = atoll(optarg);
+			break;
+
+			case 't':
+				timeout = atof(optarg);
+			break;
+
+			case 'x':
+				if (dumpmode(optarg, &dump) != 0)
+				{
+					printf("ERROR: Unknown memory dump: %s\n", optarg);
+					return 0;
+				}
+			break;
+
+			case 'o':
+				outname = optarg;
+			break;
+
+			case 'c':
+				cachedir = optarg;
+			break;
+
+			case 'b':
+				batchpath = optarg;
+			break;
+
+			case 'j':
+				threads = atoi(optarg);
+			break;
+
+			case 'd':
+				batchout = optarg;
+			break;
+
+			case 'e':
+				if (strcmp(optarg, "switch") == 0)
+				{
+					engine = ENGINE_SWITCH;
+				}
+#ifdef HAVE_THREADED
+				else if (strcmp(optarg, "threaded") == 0)
+				{
+					engine = ENGINE_THREADED;
+				}
+#endif
+#ifdef HAVE_JIT
+				else if (strcmp(optarg, "jit") == 0)
+				{
+					engine = ENGINE_JIT;
+				}
+#endif
+				else
+				{
+					printf("ERROR: Unknown engine: %s\n", optarg);
+					return 0;
+				}
+			break;
+
+			default:
+				return 0;
+		}
+	}
 
-int main (int argc, char ** argv)
-{
 //	Checks for correct number of arguements
 	
-	if (argc <= 1)
+	if (optind >= argc)
 	{
 		printf("ERROR: Not enough input arguements!\n");
 		return 0;
 	}
-	
-//	Checks for the help flag and prints the usage of this program
-	
-	char helptest[] = "-h\0";
-	char * input = (char *)malloc(sizeof(argv[1]));
-	strcpy(input, argv[1]);
-	
-	if (strcmp(input, helptest) == 0)
-	{
-		printf("This emulator can be used to run programs written in Y86 instructions.\n");
-		printf("Usage: \n");
-		printf("./y86emul <y86 file name>\n");
-		free(input);
-		return 0;
-	}
+
+	char * input = argv[optind];
 	
 //	Checks the arguement to see if it has a correct file extension
 	
 	if (strlen(input) < 5)
 	{
 		printf("ERROR: Invalid input file: %s\n", input);	
-		free(input);
 		return 0;
 	}
-//	Finds the start of the file extension
-	
-	int i = 0;
-	int j = 0;
 
+//	Finds the start of the file extension
 	
-	for (; input[i] != '\0'; i++)
-	{
-		if (input[i] == '.')
-		{
-			break;
-		}
-	}
-	
-	char fextention[] = ".y86";
-	char * temp = &input[i];
+	char * temp = strrchr(input, '.');
 	
-	if (strcmp(temp, fextention) != 0)
+	if (temp == NULL || (strcmp(temp, ".y86") != 0 && strcmp(temp, ".y86b") != 0))
 	{
-		printf("ERROR: Invalid file extension: %s\n", temp);
-		printf("This program only accepts .y86 files.\n");
+		printf("ERROR: Invalid file extension: %s\n", temp != NULL ? temp : input);
+		printf("This program only accepts .y86 and .y86b files.\n");
 		return 0;
 	}
 
 //	Gets the file after verified it is a correct *.y86 file	
 
-	char mode[] = "r\0";
-	FILE * inputfile = fopen(input, mode);
-	if (inputfile == NULL)
+	VM * vm = vmcreate();
+	unsigned long long hash = 0;
+	char * cached = NULL;
+
+	if (vm == NULL)
 	{
-		printf("ERROR: File not found: %s\n", input);
-		printf("The file must be in the same directory as the executeable.\n");
+		printf("ERROR: Out of memory\n");
 		return 0;
 	}
+	vm->engine = engine;
+	vm->noreserve = noreserve;
+	vm->guard = guard || batchpath != NULL;		// One bad run can't take the batch down with it
+	vm->budget = budget;
+	vm->timeout = timeout;
 
-	char c;
-	char * prog = (char *) calloc(1, sizeof(char));
-	prog[0] = '\0';
-	
-	do
+	if (strcmp(temp, ".y86b") == 0)
 	{
-		c = fgetc(inputfile);
-		
-		if (feof(inputfile))
+		if (vmloadimage(vm, input, 0) != 0)
 		{
-			break;
+			printf("ERROR: Invalid image file: %s\n", input);
+			vmdestroy(vm);
+			return 0;
 		}
-		
-		prog = append(prog, c);
-		
-	} while(1);
 
-	fclose(inputfile);
-	
-	//	Begin processing the file
-	//	Taking contents of file and storing it in a string
-	//	I don't like using File IO
-
-	char * duplicate = copy(prog);
-	char * token = strtok(duplicate,"\n\t\r");
-	char * memory;
-	int count = 0;
-	// First must find the .size directive
-	
-	do
+		if (showstats)
+		{
+			fprintf(stderr, "Mapped image %s (%u bytes)\n", input, vm->memsize);
+		}
+	}
+	else
 	{
-		if (strcmp(token, ".size") == 0)
+		Source src;
+		if (readsource(input, &src) != 0)
 		{
-			if (count == 0)
-			{	
-				count++;
-			}
-			else
+			printf("ERROR: File not found: %s\n", input);
+			printf("The file must be in the same directory as the executeable.\n");
+			vmdestroy(vm);
+			return 0;
+		}
+
+		if (cachedir != NULL || outname != NULL)
+		{
+			hash = hashbytes(src.text, src.length);
+		}
+
+		if (cachedir != NULL)
+		{
+			cached = cachepath(cachedir, hash);
+		}
+
+		if (cached == NULL || vmloadimage(vm, cached, hash) != 0)
+		{
+			if (parsesource(&src) != 0 || vmloadsource(vm, &src) != 0)
 			{
-				printf("ERROR:\n\t More than one .size directive has been detected. \n");
-				printf("\t Please make sure that the file has exactly one .size directive \n");
+				freesource(&src);
+				free(cached);
+				vmdestroy(vm);
 				return 0;
 			}
-			memory = strtok(NULL, "\n\t\r");	
+
+			if (showstats)
+			{
+				printloadstats(stderr, &src);
+			}
+
+			if (cached != NULL && writeimage(cached, vm->memspace, vm->memsize, vm->pc, hash) != 0)
+			{
+				fprintf(stderr, "WARNING: Could not write cached image %s\n", cached);
+			}
 		}
-		token = strtok(NULL, "\n\t\r");		//	Continue interating through the tokens
-		
-		if (token == NULL)
+		else if (showstats)
 		{
-			break;				//	Exit when we get to the last token
+			fprintf(stderr, "Mapped image %s (%u bytes)\n", cached, vm->memsize);
 		}
-	} while (1);			
+		freesource(&src);
+	}
+	free(cached);
 
-	if (count == 0)				//	Check to make sure there was a .size direvtive found in the file
+	if (batchpath != NULL)
 	{
-		printf("ERROR:\n\t No .size directive was detected in the .y86 file. \n\t Please make sure that the file has exactly one .size directive\n");
-		return 0;	
+		runbatch(vm, batchpath, threads, batchout);
 	}
-	
-	// Intialize emulators memory space
-	
-	int size = hextodec(memory);
-	
-	memsize = size;
-	memspace = (unsigned char *) malloc((size + 1) * sizeof(unsigned char));
-	
-	pc = -1;	
-	
-	for (i = 0; i < size; i++)
+	else if (serve)
 	{
-		memspace[i] = 0;
+		runserver(vm, showstats);
 	}
-	
-	// Begin looking for the other directives
-	free(duplicate);
-	
-	duplicate = copy(prog);
-	token = strtok(duplicate, "\n\t\r");
-	
-	char * arg;		//	Arguement of the directive
-	char * address;		//	Location in memory where the arg is to be stored
-	
-	int ai = 0;		//	AddressIndex dec representation of hex address in memory
-	
-	do
+	else if (outname != NULL)
 	{
-		if (strcmp(token, ".size") == 0)
+		if (writeimage(outname, vm->memspace, vm->memsize, vm->pc, hash) != 0)
 		{
-				//	Already dealt with size, but we are starting from the beginning
-			token = strtok(NULL, "\n\t\r");
+			printf("ERROR: Could not write image file: %s\n", outname);
 		}
-		else if (strcmp(token, ".text") == 0)
+	}
+	else
+	{
+		// 	Everything loaded into memory, no we execute
+	//	printmemory(vm);
+
+		struct timespec start, end;
+		Probes probes;
+		int badcache = 0;
+		int badbranch = 0;
+
+		memset(&probes, 0, sizeof(Probes));
+		if ((profile || pipeline || foldedname != NULL || cachespec != NULL || branchspec != NULL) && vm->guarded)
 		{
-			
-			address = copy(strtok(NULL, "\n\t\r"));
-			arg = copy(strtok(NULL, "\n\t\r"));
-			ai = hextodec(address);
-			
-			if (pc == -1)
+			fprintf(stderr, "WARNING: Guarded runs can't be profiled\n");
+		}
+		else if ((cachespec != NULL && (probes.cache = cachecreate(cachespec, vm->memsize, &badcache)) == NULL) ||
+			(branchspec != NULL && (probes.branch = branchcreate(branchspec, vm->memsize, &badbranch)) == NULL) ||
+			(profile && (probes.profile = profcreate(vm->memsize)) == NULL) ||
+			(foldedname != NULL && (probes.calls = callcreate(vm->pc)) == NULL) ||
+			(pipeline && (probes.pipe = pipecreate(vm->memspace, vm->memsize)) == NULL))
+		{
+			//	Every probe asked for runs, or the run doesn't
+			if (badcache)
 			{
-				pc = ai;
+				printf("ERROR: Invalid cache configuration: %s\n", cachespec);
 			}
-			else if (pc != -1)
+			else if (badbranch)
 			{
-				printf("ERROR: More than one .text directive detected\n");
-				return 0;
+				printf("ERROR: Invalid branch predictors: %s\n", branchspec);
 			}
-			
-			j = 0;
-			
-			while (j < strlen(arg))
+			else
 			{
-				memspace[ai] = (unsigned char) gettwobytes(arg, j);
-				ai++;
-				j += 2;
+				printf("ERROR: No memory for the profile\n");
 			}
-			
-			free(address);
-			free(arg);	
-		}
-		else if (strcmp(token, ".byte") == 0)
-		{
-			address = copy(strtok(NULL, "\n\t\r"));
-			arg = copy(strtok(NULL, "\n\t\r"));
-			
-			memspace[hextodec(address)] = (unsigned char) hextodec(arg);
-			
-			free(address);
-			free(arg);
+			probesfree(&probes);
+			vmdestroy(vm);
+			return 0;
 		}
-		else if (strcmp(token, ".long") == 0)
+		if (probesactive(&probes))
 		{
-			address = copy(strtok(NULL, "\n\t\r"));
-			arg = copy(strtok(NULL, "\n\t\r"));
-			
-			union converter con;
-			con.integer = atoi(arg);
-			
-			for(i = 0; i < 4; i++)
-			{
-				memspace[i+hextodec(address)] = con.byte[i];
-			}
-			
-			free(address);
-			free(arg);
+			vm->probes = &probes;
 		}
-		else if (strcmp(token, ".string") == 0)
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		vmrun(vm);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		vm->probes = NULL;
+
+		if (showstats)
 		{
-			address = copy(strtok(NULL, "\n\t\r"));
-			arg = copy(strtok(NULL, "\n\t\r"));
-			
-			int len = strlen(arg);
-			
-			i = hextodec(address);
-			
-			for(j = 1; j < len - 1; j++)
+			double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+			fprintf(stderr, "Executed %lld instructions in %.3f ms (%.1f MIPS, %s engine)\n",
+				vm->icount, secs * 1000, secs > 0 ? vm->icount / secs / 1e6 : 0,
+				vm->guarded ? "guarded" : probesactive(&probes) ? "probed" : vm->engine == ENGINE_JIT ? "jit" :
+				vm->engine == ENGINE_THREADED ? "threaded" : "switch");
+			fprintf(stderr, "Decoded %lld instructions, %lld invalidated by stores\n",
+				vm->dcache.decodes, vm->dcache.invalidations);
+#ifdef HAVE_JIT
+			if (vm->engine == ENGINE_JIT && !vm->guarded && !probesactive(&probes))
 			{
-				memspace[i] = (unsigned char)arg[j];
-				i++;
+				fprintf(stderr, "Translated %lld blocks, flushed %lld times\n",
+					vm->jit.translated, vm->jit.flushes);
 			}
-			
-			free(arg);
-			free(address);
-		}
-		else if(strcmp(token, ".bss") == 0)
-		{
-			//	BKR said he was not using the bss directive
-		}
-		else if (token[0] == '.')
-		{
-			status = INS;
-		}
-		token = strtok(NULL, "\n\t");
-		if (token == NULL)
-		{
-			break;
+#endif
 		}
-	} while (1);
-	
-	free(duplicate);
-	
-	if (status == INS)
-	{
-		printf("ERROR: Invalid directive encountered: %s\n", token);
-		return 0;
-	}
-	
-	// 	Everything loaded into memory, no we execute
-//	printmemory(size);
+		
+		printmemory(vm, dump);
+		printprobes(vm, &probes, foldedname);
+		probesfree(&probes);
 
-	executeprog();
-	
-	printmemory(size);
+	//	printstatus(vm);
+	}
 
-//	printstatus();
+	if (showmemory)
+	{
+		printresident(stderr, vm->memspace, vm->memsize);
+	}
 
-	free(memspace);
-	free(input);	
-	free(prog);	
+	vmdestroy(vm);
 	return 0;	
 }
 
-void executeprog()
-{
-	unsigned char arg1;
-	unsigned char arg2;
-	
-	int value;			// Used for any integer operations
-
-	int num1, num2;		// Used in addl, subl, mull, 
-
-	union converter con;// Used to convert between unsigned chars and ints
-
-	status = AOK;
-
-	int badscan;
+/*
+	Runs the loaded program once for every input of a batch and prints the
+	status of each run, then the totals.
+*/
 
-	char inputchar; 	// For read/write b
-	int inputword;		// For read/write w
+int runbatch (const VM * prog, const char * path, int threads, const char * outdir)
+{
+	int n, i;
+	char ** inputs = batchinputs(path, &n);
 
-	// Initialize all registers to 0
-	reg[7] = reg[6] = reg[5] = reg[4] = reg[3] = reg[2] = reg[1] = reg[0] = 0;
+	if (inputs == NULL)
+	{
+		printf("ERROR: Could not read the batch inputs: %s\n", path);
+		return -1;
+	}
 
-	// Intialize all flags to 0
-	OF = ZF = SF = 0;
+	BatchRun * runs = (BatchRun *) calloc(n > 0 ? n : 1, sizeof(BatchRun));
+	BatchStats stats;
 
+	for (i = 0; i < n; i++)
+	{
+		runs[i].input = inputs[i];
+	}
 
+	if (batchrun(prog, runs, n, threads, &stats) != 0)
+	{
+		printf("ERROR: Could not start the batch\n");
+		free(runs);
+		batchfreeinputs(inputs, n);
+		return -1;
+	}
 
-	while (status == AOK)
+	for (i = 0; i < n; i++)
 	{
-		switch (memspace[pc])
+		if (runs[i].failed)
 		{
-			// 00 NOP
-			case 0x00:
-				
-				pc++;	// NOP so program conitnues
-				
-			break;
-
-			// 10 HALT
-			case 0x10:
-				
-				status = HLT;	// Assumed this occurs at the end of program
-				
-			break;
-
-			// 20 RRMOVL srcR desR
-			case 0x20:
-				
-				getargs(&arg1, &arg2);
-				
-				reg[arg2] = reg[arg1];					//	Puts info from source into destination
-				
-				pc += 2;
-
-			break;
-
-			// 30 IRMOVL notR desR value
-			case 0x30:
-				
-				getargs(&arg1, &arg2);
-				
-				if (arg1 < 0x08)
-				{
-					status = ADR;
-					printf("ERROR: IRMOVL instruction has two addresses. Memory Location: %x\n", pc);
-					break;
-				}
-				
-				con.byte[0] = memspace[pc + 2];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 3];			// little endian order
-				con.byte[2] = memspace[pc + 4];			//
-				con.byte[3] = memspace[pc + 5];			//
-				
-				value = con.integer;					// Using union to convert between the two
-				
-				reg[arg2] = value;						// Storing final value in destination register
-				
-				pc += 6;
-
-			break;
-
-			// 40 RMMOVL srcR desR value = (32bit displacement off desR)
-			case 0x40:
-				
-				getargs(&arg1, &arg2);
-
-				con.byte[0] = memspace[pc + 2];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 3];			// little endian order
-				con.byte[2] = memspace[pc + 4];			//
-				con.byte[3] = memspace[pc + 5];			//
-				
-				value = con.integer;					// This is the offset amount
-
-				con.integer = reg[arg1];
-
-				if ((value + reg[arg2] + 3) > memsize)
-				{
-					status = ADR;
-					printf("ERROR: RMMOVL instruction address offset larger than memory space. Memory Location: %x\n", pc);
-				}
-
-				memspace[value + reg[arg2] + 0] = con.byte[0];	//
-				memspace[value + reg[arg2] + 1] = con.byte[1];	// Stores the integer at the specified location
-				memspace[value + reg[arg2] + 2] = con.byte[2];	// in little endian order
-				memspace[value + reg[arg2] + 3] = con.byte[3];	//
-
-				pc += 6;
-
-			break;
-
-			// 50 MRMOVL desR srcR value = (32bit displacement off srcR)
-			case 0x50:
-
-				getargs(&arg1, &arg2);
-
-				con.byte[0] = memspace[pc + 2];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 3];			// little endian order
-				con.byte[2] = memspace[pc + 4];			//
-				con.byte[3] = memspace[pc + 5];			//
-				
-				value = con.integer;					// This is the offset amount
-
-				if ((value + reg[arg2] + 3) > memsize)
-				{
-					status = ADR;
-					printf("ERROR: MRMOVL instruction address offset larger than memory space. Memory Location: %x\n", pc);
-				}
-
-				con.byte[0] = memspace[value + reg[arg2] + 0];	//
-				con.byte[1] = memspace[value + reg[arg2] + 1];	// Stores the integer at the specified address
-				con.byte[2] = memspace[value + reg[arg2] + 2];	// in the union to be stored in a register
-				con.byte[3] = memspace[value + reg[arg2] + 3];	//
-
-				reg[arg1] = con.integer;
-
-				pc += 6;
-
-			break;
-
-			// 60 ADDL srcR desR 
-			case 0x60:
-				
-				ZF = 0;
-				SF = 0;
-				OF = 0;
-				
-				getargs(&arg1, &arg2);
-				
-				num1 = reg[arg1];
-				num2 = reg[arg2];
-				
-				value = num1 + num2;
-
-				if (value == 0)
-				{
-					ZF = 1;
-				}
-
-				if (value < 0)
-				{
-					SF = 1;
-				}
-
-				if ((value > 0 && num1 < 0 && num2 < 0) || (value < 0 && num1 > 0 && num2 > 0))
-				{
-					OF = 1;
-				}
-
-				reg[arg2] = value;
-
-				pc += 2;
-
-			break;
-
-			// 61 SUBL srcR desR
-			case 0x61:
-				
-				ZF = 0;
-				SF = 0;
-				OF = 0;
-				
-				getargs(&arg1, &arg2);
-				
-				num1 = reg[arg1];
-				num2 = reg[arg2];
-				
-				value = num2 - num1;
-
-				if (value == 0)
-				{
-					ZF = 1;
-				}
-
-				if (value < 0)
-				{
-					SF = 1;
-				}
-
-				if ((value > 0 && num1 > 0 && num2 < 0) || (value < 0 && num1 < 0 && num2 > 0))
-				{
-					OF = 1;
-				}
-	
-				reg[arg2] = value;
-
-				pc += 2;
-
-			break;
-
-			// 62 ANDL srcR desR
-			case 0x62:
-				
-				SF = 0;
-				ZF = 0;
-				
-				getargs(&arg1, &arg2);
-				
-				num1 = reg[arg1];
-				num2 = reg[arg2];
-				
-				value = num1 & num2;
-
-				reg[arg2] = value;
-
-				if (value == 0)
-				{
-					ZF = 1;
-				}
-
-				if (value < 0)
-				{
-					SF = 1;
-				}
-
-				pc += 2;
-
-			break;
-
-			// 63 XORL srcR desR
-			case 0x63:
-				
-				ZF = 0;
-				SF = 0;
-				
-				getargs(&arg1, &arg2);
-				
-				num1 = reg[arg1];
-				num2 = reg[arg2];
-				
-				value = num1 ^ num2;
-
-				reg[arg2] = value;
-
-				if (value == 0)
-				{
-					ZF = 1;
-				}
-
-				if (value < 0)
-				{
-					SF = 1;
-				}
-
-				pc += 2;
-
-			break;
-
-			// 64 MULL srcR desR
-			case 0x64:
-
-				ZF = 0;
-				SF = 0;
-				OF = 0;
-				
-				getargs(&arg1, &arg2);
-				
-				num1 = reg[arg1];
-				num2 = reg[arg2];
-				
-				value = num1 * num2;
-
-				if (value == 0)
-				{
-					ZF = 1;
-				} 
-
-				if (value < 0)
-				{
-					SF = 1;
-				}
-
-				if ((value < 0 && num1 < 0 && num2 < 0) || 
-					(value < 0 && num1 > 0 && num2 > 0) || 
-					(value > 0 && num1 < 0 && num2 > 0) || 
-					(value > 0 && num1 > 0 && num2 < 0))
-				{
-					OF = 1;
-				}
-
-				reg[arg2] = value;
-
-				pc += 2;
-
-			break;
-
-			// 65 CMPL
-			case 0x65:
-
-				ZF = 0;
-				SF = 0;
-				OF = 0;
-				
-				getargs(&arg1, &arg2);
-				
-				num1 = reg[arg1];
-				num2 = reg[arg2];
-				
-				value = num2 - num1;
-
-				if (value == 0)
-				{
-					ZF = 1;
-				}
-
-				if (value < 0)
-				{
-					SF = 1;
-				}
-
-				if ((value > 0 && num1 > 0 && num2 < 0) || (value < 0 && num1 < 0 && num2 > 0))
-				{
-					OF = 1;
-				}
-
-				pc += 2;
-			break;
-			
-			// 70 JMP 32bit destination
-			case 0x70:
-				// Unconditional Jump
-				con.byte[0] = memspace[pc + 1];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 2];			// little endian order
-				con.byte[2] = memspace[pc + 3];			//
-				con.byte[3] = memspace[pc + 4];			//
-				
-				value = con.integer;					// This is the offset amount
-			
-				pc = value;
-
-			break;
-
-			// 71 JLE 32bit destination
-			case 0x71:
-				// Jump if less than or equal to
-				con.byte[0] = memspace[pc + 1];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 2];			// little endian order
-				con.byte[2] = memspace[pc + 3];			//
-				con.byte[3] = memspace[pc + 4];			//
-				
-				value = con.integer;					// This is the offset amount
-
-				if (ZF == 1 || (SF ^ OF))
-				{
-					pc = value;
-				}
-				else
-				{
-					pc += 5;
-				}
-
-			break;
-
-			// 72 JL  32bit destination
-			case 0x72:
-				// Jump if strictly less than
-				con.byte[0] = memspace[pc + 1];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 2];			// little endian order
-				con.byte[2] = memspace[pc + 3];			//
-				con.byte[3] = memspace[pc + 4];			//
-				
-				value = con.integer;					// This is the offset amount
-
-				if (ZF == 0 && (SF ^ OF))
-				{
-					pc = value;
-				}
-				else
-				{
-					pc += 5;
-				}
-
-			break;
-
-			// 73 JE  32bit destination
-			case 0x73:
-				// Jump if equal
-				con.byte[0] = memspace[pc + 1];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 2];			// little endian order
-				con.byte[2] = memspace[pc + 3];			//
-				con.byte[3] = memspace[pc + 4];			//
-				
-				value = con.integer;					// This is the offset amount
-
-				if (ZF == 1)
-				{
-					pc = value;
-				}
-				else
-				{
-					pc += 5;
-				}
-
-			break;
-
-			// 74 JNE 32bit destination
-			case 0x74:
-				// Jump if not equal
-				con.byte[0] = memspace[pc + 1];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 2];			// little endian order
-				con.byte[2] = memspace[pc + 3];			//
-				con.byte[3] = memspace[pc + 4];			//
-				
-				value = con.integer;					// This is the offset amouny
-
-				if (ZF == 0)
-				{
-					pc = value;
-				}
-				else
-				{
-					pc += 5;
-				}
-				
-			break;
-
-			// 75 JGE 32bit destination
-			case 0x75:
-			// Jump if greater than or equal to
-				con.byte[0] = memspace[pc + 1];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 2];			// little endian order
-				con.byte[2] = memspace[pc + 3];			//
-				con.byte[3] = memspace[pc + 4];			//
-				
-				value = con.integer;					// This is the offset amount
-
-				if (!(ZF == 0 && (SF ^ OF)))
-				{
-					pc = value;
-				}
-				else
-				{
-					pc += 5;
-				}
-
-			break;
-
-			// 76 JG  32bit destination
-			case 0x76:
-			// Jump if strictly greater than
-				con.byte[0] = memspace[pc + 1];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 2];			// little endian order
-				con.byte[2] = memspace[pc + 3];			//
-				con.byte[3] = memspace[pc + 4];			//
-				
-				value = con.integer;					// This is the offset amount
-
-				if (!(ZF == 1 || (SF ^ OF)))
-				{
-					pc = value;
-				}
-				else
-				{
-					pc += 5;
-				}
-
-			break;
-
-			// 80 CALL 32bit destination
-			case 0x80:
-
-
-				con.byte[0] = memspace[pc + 1];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 2];			// little endian order
-				con.byte[2] = memspace[pc + 3];			//
-				con.byte[3] = memspace[pc + 4];			//
-				
-				value = con.integer;					// This is the offset amount
-				
-				reg[4] -= 4;							// %ESP
-				
-				con.integer = pc + 5;
-
-				memspace[reg[4] + 0] = con.byte[0];	//
-				memspace[reg[4] + 1] = con.byte[1];	// Stores the integer at the specified location
-				memspace[reg[4] + 2] = con.byte[2];	// in little endian order
-				memspace[reg[4] + 3] = con.byte[3];	//
-
-				pc = value;
-
-			break;
-
-			// 90 RET 32bit destination
-			case 0x90:
-			
-				con.byte[0] = memspace[reg[4] + 0];	//
-				con.byte[1] = memspace[reg[4] + 1];	// Getting the value bytes
-				con.byte[2] = memspace[reg[4] + 2];	// in little endian order
-				con.byte[3] = memspace[reg[4] + 3]; //
-
-				pc = con.integer;
-
-				reg[4] += 4;
-
-			break;
-
-			// A0 PUSHL 
-			case 0xA0:
-
-				getargs(&arg1, &arg2);
-
-				reg[4] -= 4;
-
-				con.integer = reg[arg1];
-				
-				memspace[reg[4] + 0] = con.byte[0];	//
-				memspace[reg[4] + 1] = con.byte[1];	// Stores the integer at the specified location
-				memspace[reg[4] + 2] = con.byte[2];	// in little endian order
-				memspace[reg[4] + 3] = con.byte[3];	//
-
-				pc += 2;
-
-			break;
-
-			// B0 POPL
-			case 0xB0:
-
-				getargs(&arg1, &arg2);
-
-				con.byte[0] = memspace[reg[4] + 0];			// Getting the value bytes in
-				con.byte[1] = memspace[reg[4] + 1];			// little endian order
-				con.byte[2] = memspace[reg[4] + 2];			//
-				con.byte[3] = memspace[reg[4] + 3];			//
-
-				value = con.integer;
-
-				reg[arg1] = value;
-				reg[4] += 4;
-				pc += 2;
-
-			break;
-
-			// C0 READB 
-			case 0xC0:
-
-				ZF = 0;
-				
-				getargs(&arg1, &arg2);
-
-				con.byte[0] = memspace[pc + 2];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 3];			// little endian order
-				con.byte[2] = memspace[pc + 4];			//
-				con.byte[3] = memspace[pc + 5];			//
-
-				value = con.integer;
-
-				if (1 > scanf("%c", &inputchar))
-				{
-					ZF = 1;
-				}
-				
-				memspace[reg[arg1] + value] = inputchar;
-
-				pc += 6;
-
-			break;
-
-			// C1 READL
-			case 0xC1:
-
-				ZF = 0;
-				
-				getargs(&arg1, &arg2);
-
-				con.byte[0] = memspace[pc + 2];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 3];			// little endian order
-				con.byte[2] = memspace[pc + 4];			//
-				con.byte[3] = memspace[pc + 5];			//
-
-				// Store the results of the scanf to ensure we exit at the right time
-				value = con.integer;
-				badscan = scanf("%d", &inputword);
-				if (badscan < 1)
-				{
-					ZF = 1;
-				}
-				
-				con.integer = inputword;
-				memspace[reg[arg1]+ value + 0] = con.byte[0];	//
-				memspace[reg[arg1]+ value + 1] = con.byte[1];	// Stores the integer at the specified location
-				memspace[reg[arg1]+ value + 2] = con.byte[2];	// in little endian order
-				memspace[reg[arg1]+ value + 3] = con.byte[3];	//
-
-				pc += 6;
-
-			break;
-
-			// D0 WRTIEB
-			case 0xD0:
-
-				getargs(&arg1, &arg2);
-				
-				con.byte[0] = memspace[pc + 2];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 3];			// little endian order
-				con.byte[2] = memspace[pc + 4];			//
-				con.byte[3] = memspace[pc + 5];			//
+			printf("%s\tFAILED\n", runs[i].input);
+			continue;
+		}
+		printf("%s\t%s\t%lld\n", runs[i].input, statusname(runs[i].status), runs[i].icount);
 
-				value = con.integer;
-		
-				printf("%c", (char)memspace[reg[arg1] + value]);
-				pc += 6;
+		if (outdir != NULL)
+		{
+			const char * base = strrchr(runs[i].input, '/');
+			char * name = (char *) malloc(strlen(outdir) + strlen(runs[i].input) + 8);
+			FILE * out;
 
-			break;
+			sprintf(name, "%s/%s.out", outdir, base != NULL ? base + 1 : runs[i].input);
+			if ((out = fopen(name, "w")) == NULL ||
+				fwrite(runs[i].output, 1, runs[i].outlen, out) != runs[i].outlen)
+			{
+				fprintf(stderr, "WARNING: Could not write %s\n", name);
+			}
+			if (out != NULL)
+			{
+				fclose(out);
+			}
+			free(name);
+		}
+	}
 
-			// D1 WRITEL
-			case 0xD1:
+	printf("Ran %d programs on %d threads in %.3f ms (%.1f runs/s, %.1f MIPS)\n",
+		n, stats.threads, stats.seconds * 1000,
+		stats.seconds > 0 ? n / stats.seconds : 0,
+		stats.seconds > 0 ? stats.icount / stats.seconds / 1e6 : 0);
+	printf("HLT %d, ADR %d, INS %d, TMO %d, AOK %d, failed %d\n",
+		stats.count[HLT], stats.count[ADR], stats.count[INS], stats.count[TMO],
+		stats.count[AOK], stats.failed);
+
+	batchfreeruns(runs, n);
+	free(runs);
+	batchfreeinputs(inputs, n);
+	return 0;
+}
 
-				getargs(&arg1, &arg2);
-				
-				con.byte[0] = memspace[pc + 2];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 3];			// little endian order
-				con.byte[2] = memspace[pc + 4];			//
-				con.byte[3] = memspace[pc + 5];			//
+/*
+	Fork server: reads the name of an input file from each line of stdin
+	and runs the loaded program on it in a forked child.  Each run gets a
+	line with its input, status, instruction count and output length in
+	bytes, then the output itself, so a client can keep one server busy
+	without paying for a load per run.  Stops at the end of stdin or an
+	empty line.
+*/
 
-				value = con.integer;
+int runserver (VM * vm, int showstats)
+{
+	char * line = NULL;
+	size_t size = 0;
+	ssize_t len;
+	int n = 0;
+	struct timespec start, end;
 
-				con.byte[0] = memspace[value + reg[arg1] + 0];			// Getting the value bytes in
-				con.byte[1] = memspace[value + reg[arg1] + 1];			// little endian order
-				con.byte[2] = memspace[value + reg[arg1] + 2];			//
-				con.byte[3] = memspace[value + reg[arg1] + 3];			//
+	clock_gettime(CLOCK_MONOTONIC, &start);
 
-				num1 = con.integer;
-				printf("%d", num1);
-				pc += 6;
+	while ((len = getline(&line, &size, stdin)) > 0)
+	{
+		BatchRun run;
 
+		while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+		{
+			line[--len] = '\0';
+		}
+		if (len == 0)
+		{
 			break;
+		}
 
-			// E0 MOVSBL
-			case 0xE0:
-
-				getargs(&arg1, &arg2);
-
-				con.byte[0] = memspace[pc + 2];			// Getting the value bytes in
-				con.byte[1] = memspace[pc + 3];			// little endian order
-				con.byte[2] = memspace[pc + 4];			//
-				con.byte[3] = memspace[pc + 5];			//
-
-				value = con.integer;
-				
-				con.integer = reg[arg2];
-				inputchar = con.byte[3];
-				
-				// Get the first bit to see what sign we extend
-				if ((inputchar >> 7 & 1) == 0)
-				{
-					con.byte[0] = inputchar;
-					con.byte[1] = 0x00;
-					con.byte[2] = 0x00;
-					con.byte[3] = 0x00;
-				}
-				else
-				{
-					con.byte[0] = inputchar;
-					con.byte[1] = 0xff;
-					con.byte[2] = 0xff;
-					con.byte[3] = 0xff;
-				}
-					
-				con.byte[0] = memspace[reg[arg2]+ value + 0];	//
-				con.byte[0] = memspace[reg[arg2]+ value + 1];	// Stores the integer at the specified location
-				con.byte[0] = memspace[reg[arg2]+ value + 2];	// in little endian order
-				con.byte[0] = memspace[reg[arg2]+ value + 3];	//
-
-				reg[arg1] = con.integer;
-				pc += 6;
-
-			break;
-			
-			// Invalid instruction encountered			
-			default:
-				status = INS;
-			break;
+		run.input = line;
+		if (forkrun(vm, &run) != 0)
+		{
+			printf("%s\tFAILED\t0\t0\n", line);
+			if (run.signal != 0)
+			{
+				fprintf(stderr, "ERROR: The run of %s was killed by signal %d (%s)\n",
+					line, run.signal, strsignal(run.signal));
+			}
+		}
+		else
+		{
+			printf("%s\t%s\t%lld\t%zu\n", line, statusname(run.status), run.icount, run.outlen);
+			fwrite(run.output, 1, run.outlen, stdout);
+			free(run.output);
 		}
-		value = 0;
-		arg1 = arg2 = 0;
+		fflush(stdout);
+		n++;
 	}
-}
+	free(line);
 
-/*
-	Appends a character to the end of a string
-*/
-
-char * append (char * str, char c)
-{
-	int len = strlen(str) + 2;
-	char * ret = (char *)calloc(len, sizeof(char));
-	strcpy(ret, str);
-	free(str);
-	ret[len-1] = '\0';
-	ret[len-2] = c;
-	return ret;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (showstats)
+	{
+		double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+		fprintf(stderr, "Served %d runs in %.3f ms (%.1f runs/s)\n",
+			n, secs * 1000, secs > 0 ? n / secs : 0);
+	}
+	return 0;
 }
-	
 
 /*
-	Converts hex strings to an integer output using the following
-	two functions.
+	Prints the reports of every model that watched the run to stderr, and
+	writes the folded call stacks to foldedname.
 */
 
-int hextodec(char * num)
+void printprobes (const VM * vm, const Probes * probes, const char * foldedname)
 {
-	// First convert hex string to binary string
-	int size = strlen(num);
-	char * binstr = (char *) malloc((4*size + 1)*sizeof(char));
-	int i;
-	for (i = 0; i < 4*size + 1; i++)
+	if (probes->profile != NULL)
 	{
-		binstr[i] = '\0';
+		profreport(stderr, probes->profile, vm->memspace, 20);
 	}
-	for (i = 0; i < size; i++)
+	if (probes->calls != NULL)
 	{
-		strcat(binstr, hextobin(num[i]));
+		if (probes->profile != NULL)
+		{
+			fprintf(stderr, "\n");
+		}
+		FILE * folded = fopen(foldedname, "w");
+
+		if (folded == NULL)
+		{
+			fprintf(stderr, "WARNING: Could not write %s\n", foldedname);
+		}
+		else
+		{
+			callfolded(folded, probes->calls);
+			fclose(folded);
+		}
+		callreport(stderr, probes->calls, 20);
 	}
-	// Converts from binary to decimal
-	int ret = bintodec(binstr);
-	free(binstr);
-	return ret;
-}
-	
-/*
-	Converts a single hex character to the equivalent binary string
-*/
-char * hextobin(char c) 
-{
-	switch(c)
+	if (probes->cache != NULL)
 	{
-		case '0':
-		return "0000";
-		break;
-		
-		case '1':
-		return "0001";
-		break;
-		
-		case '2':
-		return "0010";
-		break;
-		
-		case '3':
-		return "0011";
-		break;
-		
-		case '4':
-		return "0100";
-		break;
-		
-		case '5':
-		return "0101";
-		break;
-		
-		case '6':
-		return "0110";
-		break;
-		
-		case '7':
-		return "0111";
-		break;
-		
-		case '8':
-		return "1000";
-		break;
-		
-		case '9':
-		return "1001";
-		break;
-		
-		case 'a':
-		case 'A':
-		return "1010";
-		break;
-		
-		case 'b':
-		case 'B':
-		return "1011";
-		break;
-		
-		case 'c':
-		case 'C':
-		return "1100";
-		break;
-		
-		case 'd':
-		case 'D':
-		return "1101";
-		break;
-		
-		case 'e':
-		case 'E':
-		return "1110";
-		break;
-		
-		case 'f':
-		case 'F':
-		return "1111";
-		break;
-		
-		case '\0':
-		break;
-		
-		default:
-		printf("Invalid hex character: %c \n", c);
-		break;
+		if (probes->profile != NULL || probes->calls != NULL)
+		{
+			fprintf(stderr, "\n");
+		}
+		cachereport(stderr, probes->cache, vm->memspace, 20);
 	}
-	return "";
-}
-	
-/*
-	Converts binary string to a decimal output
-*/
-
-int bintodec(char * num)
-{
-	int power = strlen(num) - 1;
-	int i, ret = 0;
-	for (i = 0; num[i] != '\0'; i++)
+	if (probes->pipe != NULL)
 	{
-		int temp = num[i] - '0';
-		ret += temp * (int)pow(2, power);
-		power--;
+		if (probes->profile != NULL || probes->calls != NULL || probes->cache != NULL)
+		{
+			fprintf(stderr, "\n");
+		}
+		pipereport(stderr, probes->pipe, 20);
+	}
+	if (probes->branch != NULL)
+	{
+		if (probes->profile != NULL || probes->calls != NULL || probes->cache != NULL || probes->pipe != NULL)
+		{
+			fprintf(stderr, "\n");
+		}
+		branchreport(stderr, probes->branch, vm->memspace, 20);
 	}
-	return ret;
-}
-
-/*
-	Creates a copy of the input string and returns a pointer 
-	to the new string.
-*/
-
-char * copy (char * str)
-{
-	char * ret = (char *) malloc((strlen(str) + 1) * sizeof(char));
-	strcpy(ret, str);
-	return ret;
-}
-
-/*
-	Gets *one* byte but two characters. 
-	Technically it is two bytes, but because we can assume good input, 
-	it is one byte in unsigned char
-*/
-
-int gettwobytes(char * str, int position)
-{
-	char * twobytes = (char *) malloc(3*sizeof(char));
-	
-	twobytes[2] = '\0';
-	twobytes[0] = str[position];
-	twobytes[1] = str[position + 1];
-	
-	int ret = hextodec(twobytes);
-	
-	free(twobytes);
-	
-	return ret;
 }
 
 /*
-	Utility function to see how memory is being used
+	Utility function to see how memory is being used, see y86dump.h
 */
 
-void printmemory (int size)
+void printmemory (const VM * vm, DumpMode mode)
 {
-	int i;
-	for (i = 0; i < size; i++)
-	{
-		unsigned char c = memspace[i];
-		printf("%x ", c);
-	}
-	printf("\n");
+	dumpmemory(stdout, vm->memspace, vm->memsize, mode);
 }
 
 /*
 	Utility function to see why the program stopped running
 */
 
-void printstatus ()
+void printstatus (const VM * vm)
 {
 	printf("Execution halted:\t");
-	switch (status)
+	switch (vm->status)
 	{
 		case AOK:
 			printf("AOK, program execution successful!\n");
@@ -1255,16 +610,9 @@ void printstatus ()
 		case HLT:
 			printf("HLT, halt instruction encountered.\n");
 		break;
+
+		case TMO:
+			printf("TMO, instruction budget or time limit used up.\n");
+		break;
 	}
 }
-
-/*
-	Gets the high and low portion of a byte encoding of the instructions
-	Usually used to determine registers
-*/
-
-void getargs(unsigned char * arg1, unsigned char * arg2)
-{
-	*arg1 = (memspace[pc + 1] & 0xf0) >> 4;
-	*arg2 = (memspace[pc + 1] & 0x0f);
-}
\ No newline at end of file
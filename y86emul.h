@@ -0,0 +1,16 @@
+// Ryan Bandilla
+// Y86 Emulator
+// BKR Comp Arch
+#ifndef Y86EMUL_H
+#define Y86EMUL_H
+
+#include "y86vm.h"
+#include "y86dump.h"
+
+int runbatch (const VM * prog, const char * path, int threads, const char * outdir);
+int runserver (VM * vm, int showstats);
+void printmemory (const VM * vm, DumpMode mode);
+void printprobes (const VM * vm, const Probes * probes, const char * foldedname);
+void printstatus (const VM * vm);
+
+#endif
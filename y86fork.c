@@ -0,0 +1,192 @@
+// Ryan Bandilla
+// Y86 Fork Server
+// BKR Comp Arch
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "y86fork.h"
+
+/*
+	What a child sends back ahead of its output.
+*/
+
+typedef struct
+{
+	ProgramStatus status;
+	long long icount;
+	size_t outlen;
+	int failed;
+} Reply;
+
+/*
+	Writes all n bytes of buf to fd.  Returns 0, or -1 on an error.
+*/
+
+static int writeall (int fd, const void * buf, size_t n)
+{
+	const char * p = (const char *) buf;
+
+	while (n > 0)
+	{
+		ssize_t done = write(fd, p, n);
+		if (done < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (done <= 0)
+		{
+			return -1;
+		}
+		p += done;
+		n -= done;
+	}
+	return 0;
+}
+
+/*
+	Reads exactly n bytes from fd into buf.  Returns 0, or -1 if the pipe
+	ends first.
+*/
+
+static int readall (int fd, void * buf, size_t n)
+{
+	char * p = (char *) buf;
+
+	while (n > 0)
+	{
+		ssize_t done = read(fd, p, n);
+		if (done < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (done <= 0)
+		{
+			return -1;
+		}
+		p += done;
+		n -= done;
+	}
+	return 0;
+}
+
+/*
+	The child's side of a run: runs the program on the input with the
+	output kept in memory, then sends the reply and the output to fd.
+*/
+
+static void child (VM * vm, const char * input, int fd)
+{
+	Reply reply;
+	char * output = NULL;
+	size_t outlen = 0;
+	FILE * in = fopen(input, "r");
+	FILE * out = open_memstream(&output, &outlen);
+
+	memset(&reply, 0, sizeof(Reply));
+
+	if (in == NULL || out == NULL)
+	{
+		reply.failed = 1;
+	}
+	else
+	{
+		long long before = vm->icount;
+
+		vm->in = in;
+		vm->out = out;
+		reply.status = vmrun(vm);
+		reply.icount = vm->icount - before;
+	}
+
+	if (out != NULL)
+	{
+		fclose(out);
+	}
+	reply.outlen = reply.failed ? 0 : outlen;
+
+	if (writeall(fd, &reply, sizeof(Reply)) == 0)
+	{
+		writeall(fd, output, reply.outlen);
+	}
+}
+
+/*
+	Runs the loaded program in vm once, in a forked child, with the input
+	named in run.  vm itself is never run or changed, so every run starts
+	from the state it was loaded in.  Returns 0 when the run finished, or
+	-1 with run->failed set if the child couldn't be started or died
+	before replying, and run->signal set if a signal killed it.  The
+	guest's accesses are all checked, so that is the emulator failing,
+	not the program.
+*/
+
+int forkrun (VM * vm, BatchRun * run)
+{
+	Reply reply;
+	int fds[2];
+	pid_t pid;
+	int ok;
+	int wstatus = 0;
+
+	run->status = AOK;
+	run->icount = 0;
+	run->output = NULL;
+	run->outlen = 0;
+	run->failed = 1;
+	run->signal = 0;
+
+	if (pipe(fds) != 0)
+	{
+		return -1;
+	}
+
+	// Anything still buffered would be written again by the child
+	fflush(NULL);
+
+	if ((pid = fork()) < 0)
+	{
+		close(fds[0]);
+		close(fds[1]);
+		return -1;
+	}
+	if (pid == 0)
+	{
+		close(fds[0]);
+		child(vm, run->input, fds[1]);
+		_exit(0);
+	}
+
+	close(fds[1]);
+	ok = readall(fds[0], &reply, sizeof(Reply)) == 0 && !reply.failed;
+	if (ok)
+	{
+		run->output = (char *) malloc(reply.outlen + 1);
+		ok = run->output != NULL && readall(fds[0], run->output, reply.outlen) == 0;
+	}
+	close(fds[0]);
+	while (waitpid(pid, &wstatus, 0) < 0 && errno == EINTR)
+	{
+	}
+
+	if (!ok)
+	{
+		if (WIFSIGNALED(wstatus))
+		{
+			run->signal = WTERMSIG(wstatus);
+		}
+		free(run->output);
+		run->output = NULL;
+		return -1;
+	}
+
+	run->output[reply.outlen] = '\0';
+	run->outlen = reply.outlen;
+	run->status = reply.status;
+	run->icount = reply.icount;
+	run->failed = 0;
+	return 0;
+}
@@ -0,0 +1,20 @@
+// Ryan Bandilla
+// Y86 Fork Server
+// BKR Comp Arch
+#ifndef Y86FORK_H
+#define Y86FORK_H
+
+#include "y86vm.h"
+#include "y86batch.h"
+
+/*
+ *	A fork server loads a program once and runs it any number of times in
+ *	forked children.  Each child starts from the loaded memory copy on
+ *	write, so a run costs a fork and the pages it touches instead of a
+ *	fresh load.  The run's output and status come back to the server over
+ *	a pipe and are filled in as for a batch, see BatchRun in y86batch.h.
+ */
+
+int forkrun (VM * vm, BatchRun * run);
+
+#endif
@@ -0,0 +1,512 @@
+// Ryan Bandilla
+// Y86 Workload Generator
+// BKR Comp Arch
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*
+	Writes a synthetic .y86 program that loads and halts, made from a seed
+	so the same options always give the same file.
+
+	The text starts with a jump over GENFUNCS leaf functions to the main
+	body, which runs loops times and halts.  The body is drawn from the
+	mix of instruction classes:
+
+		alu    - OPl, IRMOVL and RRMOVL on the scratch registers
+		mem    - RMMOVL, MRMOVL and MOVSBL in the data area, off %ebx = 0
+		stack  - PUSHL and POPL, popped back to empty before each loop
+		branch - A conditional jump over the next 1 to 8 instructions
+		call   - A CALL of one of the leaf functions
+		io     - WRITEB and WRITEL from the data area
+
+	%eax %ecx %edx %esi %edi are the scratch registers, %ebx is the base
+	of every access, %ebp counts the loops.  Memory is the text, the data
+	area and GENSTACK bytes of stack at the top, and the .byte, .long and
+	.string directives fill random places in the data area.
+*/
+
+#define GENFUNCS 8
+#define GENSTACK 4096
+#define GENSLACK 256			//	Text past the requested length at most
+#define GENMAXDEPTH 32			//	Pushes not yet popped
+
+typedef enum
+{
+	MIX_ALU,
+	MIX_MEM,
+	MIX_STACK,
+	MIX_BRANCH,
+	MIX_CALL,
+	MIX_IO,
+	MIXES
+} MixClass;
+
+static const char * mixname[MIXES] = { "alu", "mem", "stack", "branch", "call", "io" };
+static const int scratch[5] = { 0, 1, 2, 6, 7 };
+
+typedef struct
+{
+	unsigned long long state;	//	xorshift64*
+	int weights[MIXES];
+	unsigned int datastart;
+	unsigned int dataend;
+	unsigned int pc;			//	Address of the next byte of text
+	unsigned int funcs[GENFUNCS];
+	int depth;
+	FILE * out;
+	char buf[65536];			//	Text on its way out as hex
+	int len;
+} Gen;
+
+/*
+	Next random number of the seed.
+*/
+
+static unsigned long long next (Gen * g)
+{
+	g->state ^= g->state >> 12;
+	g->state ^= g->state << 25;
+	g->state ^= g->state >> 27;
+	return g->state * 0x2545f4914f6cdd1dULL;
+}
+
+static unsigned int below (Gen * g, unsigned int n)
+{
+	return (unsigned int) ((next(g) >> 32) % n);
+}
+
+/*
+	Parses a count with an optional k, m or g.  Returns -1 if it isn't
+	one.
+*/
+
+static long long parsecount (const char * text)
+{
+	char * end;
+	long long v = strtoll(text, &end, 0);
+
+	if (end == text || v < 0)
+	{
+		return -1;
+	}
+	switch (*end)
+	{
+		case 'k': case 'K': v <<= 10; end++; break;
+		case 'm': case 'M': v <<= 20; end++; break;
+		case 'g': case 'G': v <<= 30; end++; break;
+	}
+	return *end == '\0' ? v : -1;
+}
+
+/*
+	Parses class:weight pairs separated by commas over the weights.
+	Returns 0, or -1 if part of it can't be parsed.
+*/
+
+static int parsemix (const char * text, int * weights)
+{
+	while (*text != '\0')
+	{
+		const char * colon = strchr(text, ':');
+		char * end;
+		int i;
+
+		if (colon == NULL)
+		{
+			return -1;
+		}
+		for (i = 0; i < MIXES; i++)
+		{
+			if (strlen(mixname[i]) == (size_t) (colon - text) && strncmp(text, mixname[i], colon - text) == 0)
+			{
+				break;
+			}
+		}
+		if (i == MIXES)
+		{
+			return -1;
+		}
+		weights[i] = (int) strtol(colon + 1, &end, 10);
+		if (end == colon + 1 || weights[i] < 0 || (*end != ',' && *end != '\0'))
+		{
+			return -1;
+		}
+		text = *end == ',' ? end + 1 : end;
+	}
+	return 0;
+}
+
+/*
+	Writes n bytes of text as hex.
+*/
+
+static void emit (Gen * g, const unsigned char * bytes, int n)
+{
+	static const char digits[] = "0123456789abcdef";
+	int i;
+
+	if (g->len + 2 * n > (int) sizeof(g->buf))
+	{
+		fwrite(g->buf, 1, g->len, g->out);
+		g->len = 0;
+	}
+	for (i = 0; i < n; i++)
+	{
+		g->buf[g->len++] = digits[bytes[i] >> 4];
+		g->buf[g->len++] = digits[bytes[i] & 0xf];
+	}
+	g->pc += n;
+}
+
+/*
+	Encodes an instruction of op with the register byte regs (if len is
+	over 1) and the 32 bit value (if len is 5 or 6) into b.  Returns len.
+*/
+
+static int encode (unsigned char * b, unsigned char op, int regs, unsigned int value, int len)
+{
+	int at = 1;
+
+	b[0] = op;
+	if (len == 2 || len == 6)
+	{
+		b[at++] = (unsigned char) regs;
+	}
+	if (len >= 5)
+	{
+		b[at++] = (unsigned char) value;
+		b[at++] = (unsigned char) (value >> 8);
+		b[at++] = (unsigned char) (value >> 16);
+		b[at++] = (unsigned char) (value >> 24);
+	}
+	return len;
+}
+
+static int reg (Gen * g)
+{
+	return scratch[below(g, 5)];
+}
+
+/*
+	A random address for n bytes in the data area.
+*/
+
+static unsigned int dataaddr (Gen * g, unsigned int n)
+{
+	return g->datastart + (below(g, (g->dataend - g->datastart - n) / 4 + 1) * 4);
+}
+
+/*
+	One instruction of class c into b.  Returns its length.
+*/
+
+static int instruction (Gen * g, MixClass c, unsigned char * b)
+{
+	if ((c == MIX_MEM || c == MIX_IO) && g->dataend - g->datastart < 8)
+	{
+		c = MIX_ALU;
+	}
+
+	switch (c)
+	{
+		case MIX_MEM:
+			switch (below(g, 3))
+			{
+				case 0:
+					return encode(b, 0x40, reg(g) << 4 | 3, dataaddr(g, 4), 6);
+				case 1:
+					return encode(b, 0x50, reg(g) << 4 | 3, dataaddr(g, 4), 6);
+				default:
+					return encode(b, 0xE0, reg(g) << 4 | 3, dataaddr(g, 4), 6);
+			}
+
+		case MIX_STACK:
+			if (g->depth > 0 && (g->depth == GENMAXDEPTH || below(g, 2) == 0))
+			{
+				g->depth--;
+				return encode(b, 0xB0, reg(g) << 4 | 0xf, 0, 2);
+			}
+			g->depth++;
+			return encode(b, 0xA0, reg(g) << 4 | 0xf, 0, 2);
+
+		case MIX_CALL:
+			return encode(b, 0x80, 0, g->funcs[below(g, GENFUNCS)], 5);
+
+		case MIX_IO:
+			if (below(g, 2) == 0)
+			{
+				return encode(b, 0xD0, 3 << 4 | 0xf, dataaddr(g, 1), 6);
+			}
+			return encode(b, 0xD1, 3 << 4 | 0xf, dataaddr(g, 4), 6);
+
+		default:
+			switch (below(g, 8))
+			{
+				case 0:
+					return encode(b, 0x30, 0xf0 | reg(g), (unsigned int) next(g), 6);
+				case 1:
+					return encode(b, 0x20, reg(g) << 4 | reg(g), 0, 2);
+				default:
+					return encode(b, 0x60 + below(g, 6), reg(g) << 4 | reg(g), 0, 2);
+			}
+	}
+}
+
+/*
+	A class drawn from the weights, leaving out those with skip set.
+*/
+
+static MixClass pick (Gen * g, const int * skip)
+{
+	int total = 0, i, r;
+
+	for (i = 0; i < MIXES; i++)
+	{
+		total += skip[i] ? 0 : g->weights[i];
+	}
+	if (total == 0)
+	{
+		return MIX_ALU;
+	}
+	r = (int) below(g, total);
+	for (i = 0; i < MIXES; i++)
+	{
+		if (!skip[i] && (r -= g->weights[i]) < 0)
+		{
+			break;
+		}
+	}
+	return (MixClass) i;
+}
+
+/*
+	Writes the .text directive: the jump to main, the leaf functions and
+	a body of about textlen bytes run loops times.
+*/
+
+static void writetext (Gen * g, unsigned long long textlen, unsigned int loops, unsigned int stacktop)
+{
+	static const int none[MIXES] = { 0, 0, 0, 0, 0, 0 };
+	static const int inblock[MIXES] = { 0, 0, 1, 1, 0, 0 };
+	unsigned char b[64], block[8 * 6], funcs[GENFUNCS * 25];
+	unsigned int top;
+	int i, k, n, len;
+
+	fprintf(g->out, ".text\t0\t");
+
+	// Leaf functions of 1 to 4 ALU instructions and a RET, behind a jump
+	// to main
+	for (i = 0, len = 0; i < GENFUNCS; i++)
+	{
+		g->funcs[i] = 5 + len;
+		for (k = 1 + below(g, 4); k > 0; k--)
+		{
+			len += instruction(g, MIX_ALU, funcs + len);
+		}
+		funcs[len++] = 0x90;
+	}
+	emit(g, b, encode(b, 0x70, 0, 5 + len, 5));
+	emit(g, funcs, len);
+
+	emit(g, b, encode(b, 0x30, 0xf3, 0, 6));
+	emit(g, b, encode(b, 0x30, 0xf4, stacktop, 6));
+	emit(g, b, encode(b, 0x30, 0xf5, loops, 6));
+	top = g->pc;
+
+	while (g->pc < top + textlen)
+	{
+		MixClass c = pick(g, none);
+
+		if (c != MIX_BRANCH)
+		{
+			emit(g, b, instruction(g, c, b));
+			continue;
+		}
+		n = 1 + below(g, 8);
+		for (k = len = 0; k < n; k++)
+		{
+			len += instruction(g, pick(g, inblock), block + len);
+		}
+		emit(g, b, encode(b, 0x71 + below(g, 6), 0, g->pc + 5 + len, 5));
+		emit(g, block, len);
+	}
+
+	for (; g->depth > 0; g->depth--)
+	{
+		emit(g, b, encode(b, 0xB0, reg(g) << 4 | 0xf, 0, 2));
+	}
+	emit(g, b, encode(b, 0x30, 0xf2, 0xffffffff, 6));
+	emit(g, b, encode(b, 0x60, 0x25, 0, 2));
+	emit(g, b, encode(b, 0x74, 0, top, 5));
+	b[0] = 0x10;
+	emit(g, b, 1);
+
+	fwrite(g->buf, 1, g->len, g->out);
+	g->len = 0;
+	fprintf(g->out, "\n");
+}
+
+/*
+	Writes n of each of the .byte, .long and .string directives into the
+	data area.
+*/
+
+static void writedata (Gen * g, long long bytes, long long longs, long long strings)
+{
+	static const char letters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ";
+	char text[33];
+	long long i;
+	int k, n;
+
+	if (g->dataend - g->datastart < 40)
+	{
+		return;
+	}
+	for (i = 0; i < bytes; i++)
+	{
+		fprintf(g->out, ".byte\t%08x\t%02x\n", dataaddr(g, 1), below(g, 256));
+	}
+	for (i = 0; i < longs; i++)
+	{
+		fprintf(g->out, ".long\t%x\t%d\n", dataaddr(g, 4), (int) next(g));
+	}
+	for (i = 0; i < strings; i++)
+	{
+		n = 1 + below(g, 32);
+		for (k = 0; k < n; k++)
+		{
+			text[k] = letters[below(g, sizeof(letters) - 1)];
+		}
+		text[n] = '\0';
+		fprintf(g->out, ".string\t%x\t\"%s\"\n", dataaddr(g, 32), text);
+	}
+}
+
+int main (int argc, char ** argv)
+{
+	Gen * g = (Gen *) calloc(1, sizeof(Gen));
+	unsigned long long seed = 1;			//	-s
+	long long textlen = 4096;				//	Bytes of body, -t
+	long long size = 0;						//	.size, -S, 0 to fit
+	long long datalen = 65536;				//	Data area when size is left to fit
+	long long loops = 1;					//	-n
+	long long bytes = 0, longs = 0, strings = 0;
+	char * outname = NULL;
+	long long textend;
+	int opt;
+
+	if (g == NULL)
+	{
+		printf("ERROR: Out of memory\n");
+		return 1;
+	}
+	g->weights[MIX_ALU] = 60;
+	g->weights[MIX_MEM] = 20;
+	g->weights[MIX_STACK] = 8;
+	g->weights[MIX_BRANCH] = 8;
+	g->weights[MIX_CALL] = 4;
+
+	while ((opt = getopt(argc, argv, "hs:t:S:n:b:l:r:m:o:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'h':
+				printf("Writes a synthetic Y86 program made from a seed.\n");
+				printf("Usage: \n");
+				printf("./y86gen [-s seed] [-t text] [-S size] [-n loops] [-b bytes] [-l longs] [-r strings] [-m mix] [-o file]\n");
+				printf("\t-s\tseed, 1 by default; the same options and seed give the same program\n");
+				printf("\t-t\tbytes of instructions in the main body, 4096 by default, k, m and g allowed\n");
+				printf("\t-S\tthe .size of the program, by default the text and 64k of data and 4k of stack\n");
+				printf("\t-n\ttimes the main body runs before the program halts, 1 by default\n");
+				printf("\t-b\t.byte directives to write into the data area\n");
+				printf("\t-l\t.long directives to write into the data area\n");
+				printf("\t-r\t.string directives to write into the data area\n");
+				printf("\t-m\tweights of the instruction classes alu, mem, stack, branch, call and io,\n");
+				printf("\t\tdefault alu:60,mem:20,stack:8,branch:8,call:4,io:0\n");
+				printf("\t-o\tfile to write, stdout by default\n");
+				return 0;
+
+			case 's':
+				seed = strtoull(optarg, NULL, 0);
+			break;
+
+			case 't':
+				textlen = parsecount(optarg);
+			break;
+
+			case 'S':
+				size = parsecount(optarg);
+			break;
+
+			case 'n':
+				loops = parsecount(optarg);
+			break;
+
+			case 'b':
+				bytes = parsecount(optarg);
+			break;
+
+			case 'l':
+				longs = parsecount(optarg);
+			break;
+
+			case 'r':
+				strings = parsecount(optarg);
+			break;
+
+			case 'm':
+				if (parsemix(optarg, g->weights) != 0)
+				{
+					printf("ERROR: Invalid instruction mix: %s\n", optarg);
+					return 1;
+				}
+			break;
+
+			case 'o':
+				outname = optarg;
+			break;
+		}
+	}
+
+	// Room for the start, the functions and the end around the body
+	textend = textlen + 5 + GENFUNCS * 25 + 18 + GENMAXDEPTH * 2 + 14 + GENSLACK;
+	if (size == 0)
+	{
+		size = textend + datalen + GENSTACK;
+	}
+	if (textlen < 0 || loops < 1 || loops > 0x7fffffff || bytes < 0 || longs < 0 || strings < 0)
+	{
+		printf("ERROR: Invalid count, see -h\n");
+		return 1;
+	}
+	if (size < 0 || size > 0x7fffffff || size < textend + GENSTACK)
+	{
+		printf("ERROR: Invalid size, it must hold the text and the stack: %lld\n", size);
+		return 1;
+	}
+
+	g->out = outname != NULL ? fopen(outname, "w") : stdout;
+	if (g->out == NULL)
+	{
+		printf("ERROR: Could not write %s\n", outname);
+		return 1;
+	}
+	g->state = seed * 0x9e3779b97f4a7c15ULL + 1;
+	g->datastart = (unsigned int) (textend + 3) & ~3u;
+	g->dataend = (unsigned int) (size - GENSTACK);
+
+	fprintf(g->out, "# y86gen -s %llu -t %lld -S %lld -n %lld\n", seed, textlen, size, loops);
+	fprintf(g->out, ".size\t%llx\n", size);
+	writetext(g, (unsigned long long) textlen, (unsigned int) loops, (unsigned int) size & ~3u);
+	writedata(g, bytes, longs, strings);
+
+	if (fflush(g->out) != 0 || (outname != NULL && fclose(g->out) != 0))
+	{
+		printf("ERROR: Could not write %s\n", outname != NULL ? outname : "stdout");
+		return 1;
+	}
+	free(g);
+	return 0;
+}
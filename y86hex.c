@@ -0,0 +1,228 @@
+// Ryan Bandilla
+// Y86 Hex Decoding
+// BKR Comp Arch
+#include <stdio.h>
+#include "y86hex.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(Y86_NOSIMD)
+#define Y86_SIMDHEX
+#include <immintrin.h>
+#endif
+
+const signed char hexvalue[256] =
+{
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+/*
+	Converts the len hex characters at num to an integer.
+	Characters that aren't hex digits are reported and skipped, the same
+	way the old hextobin()/bintodec() pair treated them.
+*/
+
+int hextodec (const char * num, size_t len)
+{
+	unsigned int ret = 0;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		int v = hexvalue[(unsigned char) num[i]];
+		if (v < 0)
+		{
+			printf("Invalid hex character: %c \n", num[i]);
+			continue;
+		}
+		ret = (ret << 4) | v;
+	}
+	return (int) ret;
+}
+
+/*
+	Decodes the pair of characters at str into one byte.
+	A single trailing character (len == 1) is a byte on its own.
+*/
+
+static unsigned char hexpair (const char * str, size_t len)
+{
+	int hi = hexvalue[(unsigned char) str[0]];
+	int lo = len > 1 ? hexvalue[(unsigned char) str[1]] : -1;
+
+	if (hi >= 0 && lo >= 0)
+	{
+		return (unsigned char) (hi << 4 | lo);
+	}
+
+	if (hi < 0)
+	{
+		printf("Invalid hex character: %c \n", str[0]);
+	}
+	if (len > 1 && lo < 0)
+	{
+		printf("Invalid hex character: %c \n", str[1]);
+	}
+	return (unsigned char) (hi >= 0 ? hi : lo >= 0 ? lo : 0);
+}
+
+static size_t hexscalar (const char * str, size_t len, unsigned char * out)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i + 1 < len; i += 2)
+	{
+		int hi = hexvalue[(unsigned char) str[i]];
+		int lo = hexvalue[(unsigned char) str[i + 1]];
+
+		if ((hi | lo) < 0)
+		{
+			out[n++] = hexpair(str + i, 2);
+		}
+		else
+		{
+			out[n++] = (unsigned char) (hi << 4 | lo);
+		}
+	}
+	if (i < len)
+	{
+		out[n++] = hexpair(str + i, 1);
+	}
+	return n;
+}
+
+#ifdef Y86_SIMDHEX
+
+/*
+	Turns 16 hex characters into 16 nibbles and sets *valid to the mask of
+	lanes that held a hex digit.
+*/
+
+__attribute__((target("ssse3")))
+static __m128i nibbles128 (__m128i c, int * valid)
+{
+	__m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+	__m128i l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+	__m128i isd = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+	__m128i isl = _mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(5)), l);
+
+	*valid = _mm_movemask_epi8(_mm_or_si128(isd, isl));
+	return _mm_or_si128(_mm_and_si128(isd, d),
+		_mm_and_si128(isl, _mm_add_epi8(l, _mm_set1_epi8(10))));
+}
+
+__attribute__((target("ssse3")))
+static size_t hexssse3 (const char * str, size_t len, unsigned char * out)
+{
+	const __m128i weights = _mm_set1_epi16(0x0110);
+	size_t i = 0;
+
+	for (; i + 32 <= len; i += 32)
+	{
+		int v0, v1;
+		__m128i a = nibbles128(_mm_loadu_si128((const __m128i *) (str + i)), &v0);
+		__m128i b = nibbles128(_mm_loadu_si128((const __m128i *) (str + i + 16)), &v1);
+
+		if ((v0 & v1) != 0xffff)
+		{
+			hexscalar(str + i, 32, out + i / 2);
+			continue;
+		}
+
+		//	Each pair becomes hi * 16 + lo in a 16 bit lane, then narrows to a byte
+		a = _mm_maddubs_epi16(a, weights);
+		b = _mm_maddubs_epi16(b, weights);
+		_mm_storeu_si128((__m128i *) (out + i / 2), _mm_packus_epi16(a, b));
+	}
+	return i / 2 + hexscalar(str + i, len - i, out + i / 2);
+}
+
+__attribute__((target("avx2")))
+static __m256i nibbles256 (__m256i c, unsigned int * valid)
+{
+	__m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+	__m256i l = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+	__m256i isd = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+	__m256i isl = _mm256_cmpeq_epi8(_mm256_min_epu8(l, _mm256_set1_epi8(5)), l);
+
+	*valid = (unsigned int) _mm256_movemask_epi8(_mm256_or_si256(isd, isl));
+	return _mm256_or_si256(_mm256_and_si256(isd, d),
+		_mm256_and_si256(isl, _mm256_add_epi8(l, _mm256_set1_epi8(10))));
+}
+
+__attribute__((target("avx2")))
+static size_t hexavx2 (const char * str, size_t len, unsigned char * out)
+{
+	const __m256i weights = _mm256_set1_epi16(0x0110);
+	size_t i = 0;
+
+	for (; i + 64 <= len; i += 64)
+	{
+		unsigned int v0, v1;
+		__m256i a = nibbles256(_mm256_loadu_si256((const __m256i *) (str + i)), &v0);
+		__m256i b = nibbles256(_mm256_loadu_si256((const __m256i *) (str + i + 32)), &v1);
+
+		if ((v0 & v1) != 0xffffffffu)
+		{
+			hexscalar(str + i, 64, out + i / 2);
+			continue;
+		}
+
+		//	packus works within 128 bit lanes, so put the quadwords back in order
+		a = _mm256_maddubs_epi16(a, weights);
+		b = _mm256_maddubs_epi16(b, weights);
+		_mm256_storeu_si256((__m256i *) (out + i / 2),
+			_mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8));
+	}
+	return i / 2 + hexscalar(str + i, len - i, out + i / 2);
+}
+
+#endif
+
+/*
+	Decodes a string of hex digit pairs (a .text payload) into bytes.
+	Long strings go through the widest vector decoder the host supports.
+	Returns the number of bytes written, (len + 1) / 2.
+*/
+
+size_t hextobytes (const char * str, size_t len, unsigned char * out)
+{
+#ifdef Y86_SIMDHEX
+	static size_t (*decoder) (const char *, size_t, unsigned char *);
+
+	if (decoder == NULL)
+	{
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+		{
+			decoder = hexavx2;
+		}
+		else if (__builtin_cpu_supports("ssse3"))
+		{
+			decoder = hexssse3;
+		}
+		else
+		{
+			decoder = hexscalar;
+		}
+	}
+	if (len >= 32)
+	{
+		return decoder(str, len, out);
+	}
+#endif
+	return hexscalar(str, len, out);
+}
@@ -0,0 +1,18 @@
+// Ryan Bandilla
+// Y86 Hex Decoding
+// BKR Comp Arch
+#ifndef Y86HEX_H
+#define Y86HEX_H
+
+#include <stddef.h>
+
+/*
+ *	Value of every character as a hex digit, or -1 if it isn't one
+ */
+
+extern const signed char hexvalue[256];
+
+int hextodec (const char * num, size_t len);
+size_t hextobytes (const char * str, size_t len, unsigned char * out);
+
+#endif
@@ -0,0 +1,258 @@
+// Ryan Bandilla
+// Y86 Binary Images
+// BKR Comp Arch
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "y86image.h"
+#include "y86mem.h"
+
+#define FNVOFFSET 0xcbf29ce484222325ULL
+#define FNVPRIME 0x100000001b3ULL
+
+/*
+	64 bit FNV-1a style hash, folded a word at a time so hashing a large
+	.y86 file costs far less than parsing it.  Used as the cache key.
+*/
+
+unsigned long long hashbytes (const void * data, size_t len)
+{
+	const unsigned char * p = (const unsigned char *) data;
+	unsigned long long h = FNVOFFSET ^ len;
+	size_t i = 0;
+
+	for (; i + 8 <= len; i += 8)
+	{
+		unsigned long long word;
+		memcpy(&word, p + i, 8);
+		h = (h ^ word) * FNVPRIME;
+		h ^= h >> 29;
+	}
+	for (; i < len; i++)
+	{
+		h = (h ^ p[i]) * FNVPRIME;
+	}
+	return h;
+}
+
+/*
+	Writes len bytes, retrying short writes.
+*/
+
+static int writeall (int fd, const void * buf, size_t len)
+{
+	const char * p = (const char *) buf;
+
+	while (len > 0)
+	{
+		ssize_t put = write(fd, p, len);
+		if (put < 0)
+		{
+			return -1;
+		}
+		p += put;
+		len -= put;
+	}
+	return 0;
+}
+
+/*
+	Writes memory at offset, leaving holes in the file for pages that are
+	entirely zero so sparse programs give sparse images.
+*/
+
+static int writesparse (int fd, off_t offset, const unsigned char * mem, size_t len, size_t page)
+{
+	size_t i, n;
+
+	if (lseek(fd, offset, SEEK_SET) < 0)
+	{
+		return -1;
+	}
+
+	for (i = 0; i < len; i += n)
+	{
+		n = len - i < page ? len - i : page;
+
+		size_t k = 0;
+		while (k < n && mem[i + k] == 0)
+		{
+			k++;
+		}
+
+		if (k == n)
+		{
+			if (lseek(fd, n, SEEK_CUR) < 0)
+			{
+				return -1;
+			}
+		}
+		else if (writeall(fd, mem + i, n) != 0)
+		{
+			return -1;
+		}
+	}
+	return ftruncate(fd, offset + len);
+}
+
+/*
+	Writes an image of memory to the named file.
+	The image is written to a temporary file and renamed into place, so a
+	reader (another emulator sharing the cache) never sees half of one.
+	Returns 0 on success and -1 on failure.
+*/
+
+int writeimage (const char * name, const unsigned char * mem, unsigned int memsize,
+	int pc, unsigned long long hash)
+{
+	ImageHeader header;
+	long page = sysconf(_SC_PAGESIZE);
+	char * temp = (char *) malloc(strlen(name) + 32);
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, IMAGEMAGIC, 4);
+	header.version = IMAGEVERSION;
+	header.byteorder = IMAGEORDER;
+	header.memsize = memsize;
+	header.pc = pc;
+	header.dataoffset = page;
+	header.hash = hash;
+
+	sprintf(temp, "%s.%d.tmp", name, (int) getpid());
+	int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		free(temp);
+		return -1;
+	}
+
+	if (writeall(fd, &header, sizeof(header)) != 0 ||
+		writesparse(fd, header.dataoffset, mem, memsize, page) != 0 ||
+		close(fd) != 0 ||
+		rename(temp, name) != 0)
+	{
+		unlink(temp);
+		free(temp);
+		return -1;
+	}
+
+	free(temp);
+	return 0;
+}
+
+/*
+	Maps the data extents of the file from offset over mem.  The holes
+	writesparse() left stay anonymous demand-zero memory, so a sparse image
+	costs no more to run than the program it came from.
+	Returns -1 if the file system can't report its extents.
+*/
+
+static int mapextents (int fd, off_t offset, unsigned char * mem, size_t len, long page)
+{
+	off_t end = offset + len;
+	off_t data = offset;
+
+	while ((data = lseek(fd, data, SEEK_DATA)) >= 0 && data < end)
+	{
+		off_t hole = lseek(fd, data, SEEK_HOLE);
+		if (hole < 0 || hole > end)
+		{
+			hole = end;
+		}
+
+		off_t first = data - (data - offset) % page;
+		if (mmap(mem + (first - offset), hole - first, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_FIXED, fd, first) == MAP_FAILED)
+		{
+			return -1;
+		}
+		data = hole;
+	}
+	return 0;
+}
+
+/*
+	Loads the memory of an image.  The file's pages are mapped privately,
+	so loading is a page-in and the program's writes never reach the file.
+	When hash is nonzero the image must have been built from text with that
+	hash.
+	Returns 0 on success and -1 if the file is missing, stale or not an image.
+*/
+
+int mapimage (const char * name, unsigned long long hash, Image * img)
+{
+	ImageHeader header;
+	struct stat st;
+	long page = sysconf(_SC_PAGESIZE);
+
+	memset(img, 0, sizeof(Image));
+
+	int fd = open(name, O_RDONLY);
+	if (fd < 0)
+	{
+		return -1;
+	}
+
+	if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+		memcmp(header.magic, IMAGEMAGIC, 4) != 0 ||
+		header.version != IMAGEVERSION ||
+		header.byteorder != IMAGEORDER ||
+		(hash != 0 && header.hash != hash) ||
+		fstat(fd, &st) != 0 ||
+		(unsigned long long) st.st_size < (unsigned long long) header.dataoffset + header.memsize)
+	{
+		close(fd);
+		return -1;
+	}
+
+	img->memsize = header.memsize;
+	img->pc = header.pc;
+	img->mem = memalloc(header.memsize, 0);
+
+	if (img->mem == NULL)
+	{
+		close(fd);
+		return -1;
+	}
+
+	//	Written on a host with a larger page size, or no extent support: read it
+	if (header.dataoffset % page != 0 ||
+		mapextents(fd, header.dataoffset, img->mem, header.memsize, page) != 0)
+	{
+		if (pread(fd, img->mem, header.memsize, header.dataoffset) != (ssize_t) header.memsize)
+		{
+			unmapimage(img);
+			close(fd);
+			return -1;
+		}
+	}
+	close(fd);
+	return 0;
+}
+
+/*
+	Releases the memory of an image.
+*/
+
+void unmapimage (Image * img)
+{
+	memfree(img->mem, img->memsize);
+	memset(img, 0, sizeof(Image));
+}
+
+/*
+	Name of the cached image for text with the given hash.
+	The caller frees the returned string.
+*/
+
+char * cachepath (const char * dir, unsigned long long hash)
+{
+	char * path = (char *) malloc(strlen(dir) + 32);
+	sprintf(path, "%s/%016llx.y86b", dir, hash);
+	return path;
+}
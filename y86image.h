@@ -0,0 +1,52 @@
+// Ryan Bandilla
+// Y86 Binary Images
+// BKR Comp Arch
+#ifndef Y86IMAGE_H
+#define Y86IMAGE_H
+
+#include <stddef.h>
+
+/*
+ *	A .y86b image is the emulator's memory after every directive of a .y86
+ *	file has been applied, so it can be mapped and run without parsing.
+ *
+ *	Layout:
+ *		ImageHeader
+ *		zero padding up to header.dataoffset (a multiple of the page size)
+ *		header.memsize bytes of memory
+ */
+
+#define IMAGEMAGIC "Y86B"
+#define IMAGEVERSION 1
+#define IMAGEORDER 0x01020304u
+
+typedef struct
+{
+	char magic[4];				//	IMAGEMAGIC
+	unsigned int version;		//	IMAGEVERSION
+	unsigned int byteorder;		//	IMAGEORDER as written by the host that made it
+	unsigned int memsize;		//	Bytes of memory, the .size directive
+	int pc;						//	Address of the .text directive
+	unsigned int dataoffset;	//	File offset of the memory
+	unsigned long long hash;	//	hashbytes() of the .y86 text it was built from
+} ImageHeader;
+
+/*
+ *	An image loaded into guest memory (see y86mem.h) ready to run
+ */
+
+typedef struct
+{
+	unsigned char * mem;
+	unsigned int memsize;
+	int pc;
+} Image;
+
+unsigned long long hashbytes (const void * data, size_t len);
+int writeimage (const char * name, const unsigned char * mem, unsigned int memsize,
+	int pc, unsigned long long hash);
+int mapimage (const char * name, unsigned long long hash, Image * img);
+void unmapimage (Image * img);
+char * cachepath (const char * dir, unsigned long long hash);
+
+#endif
@@ -0,0 +1,142 @@
+// Ryan Bandilla
+// Y86 Guest I/O
+// BKR Comp Arch
+#include <stdio.h>
+#include <limits.h>
+#include <unistd.h>
+#include "y86io.h"
+
+/*
+	Starts the I/O of a run on the VM's streams with an empty buffer.
+*/
+
+void iobegin (GuestIO * io, FILE * in, FILE * out)
+{
+	io->in = in;
+	io->out = out;
+	io->interactive = in != NULL && isatty(fileno(in));
+	io->len = 0;
+}
+
+/*
+	Writes out everything in the buffer.
+*/
+
+void ioflush (GuestIO * io)
+{
+	if (io->len > 0)
+	{
+		fwrite(io->buf, 1, io->len, io->out);
+		io->len = 0;
+	}
+}
+
+/*
+	Adds n in decimal, as printf("%d") writes it.
+*/
+
+void ioputint (GuestIO * io, int n)
+{
+	char digits[12];
+	int i = 0;
+	unsigned int u = n < 0 ? 0u - (unsigned int) n : (unsigned int) n;
+
+	if (IOBUFSIZE - io->len < sizeof(digits))
+	{
+		ioflush(io);
+	}
+
+	do
+	{
+		digits[i++] = (char) ('0' + u % 10);
+		u /= 10;
+	} while (u != 0);
+
+	if (n < 0)
+	{
+		io->buf[io->len++] = '-';
+	}
+	while (i > 0)
+	{
+		io->buf[io->len++] = digits[--i];
+	}
+}
+
+/*
+	Whether ch is white space that scanf skips.
+*/
+
+static int isblankchar (int ch)
+{
+	return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+/*
+	Reads a decimal number into n the way scanf("%d") does: white space
+	is skipped, then an optional sign and the digits, and the character
+	after them is put back.  A number too large for a long is clamped to
+	LONG_MAX or LONG_MIN and then cut down to an int, as glibc does.
+	Returns 1, 0 if the input doesn't start with a number or EOF at the
+	end of input, and n is only changed on 1.
+*/
+
+int iogetint (GuestIO * io, int * n)
+{
+	FILE * in = io->in;
+	unsigned long long mag = 0;
+	unsigned long long max;
+	int negative = 0;
+	int overflow = 0;
+	int digits = 0;
+	int ch;
+
+	if (io->interactive)
+	{
+		ioflush(io);
+		fflush(io->out);
+	}
+
+	while ((ch = getc_unlocked(in)) != EOF && isblankchar(ch))
+	{
+	}
+	if (ch == EOF)
+	{
+		return EOF;
+	}
+
+	if (ch == '-' || ch == '+')
+	{
+		negative = ch == '-';
+		ch = getc_unlocked(in);
+	}
+	max = negative ? (unsigned long long) LONG_MAX + 1 : (unsigned long long) LONG_MAX;
+
+	while (ch >= '0' && ch <= '9')
+	{
+		if (!overflow && mag <= (max - (ch - '0')) / 10)
+		{
+			mag = mag * 10 + (ch - '0');
+		}
+		else
+		{
+			overflow = 1;
+		}
+		digits++;
+		ch = getc_unlocked(in);
+	}
+	if (ch != EOF)
+	{
+		ungetc(ch, in);
+	}
+
+	if (digits == 0)
+	{
+		return 0;
+	}
+	if (overflow)
+	{
+		mag = max;
+	}
+	*n = (int) (negative ? 0 - mag : mag);
+	return 1;
+}
@@ -0,0 +1,73 @@
+// Ryan Bandilla
+// Y86 Guest I/O
+// BKR Comp Arch
+#ifndef Y86IO_H
+#define Y86IO_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/*
+ *	The READB, READL, WRITEB and WRITEL instructions of one run.  Output
+ *	collects in buf and goes to the out stream when it fills up and when
+ *	the run stops, so an instruction costs a store instead of a printf.
+ *	Run time errors are written to out directly and have to call ioflush()
+ *	first to stay in order.
+ *
+ *	Input is read a character at a time through the in stream's own
+ *	buffer, and nothing is read ahead of what the program asked for, so
+ *	a later run on the same stream carries on where this one stopped.
+ *	iogetint() reads a number the way scanf("%d") does.
+ *
+ *	When in is a terminal the output is flushed before every read, so a
+ *	prompt shows up before the program waits for the answer.
+ */
+
+#define IOBUFSIZE 65536
+
+typedef struct
+{
+	FILE * in;
+	FILE * out;
+	int interactive;			//	in is a terminal
+	size_t len;					//	Bytes waiting in buf
+	char buf[IOBUFSIZE];
+} GuestIO;
+
+void iobegin (GuestIO * io, FILE * in, FILE * out);
+void ioflush (GuestIO * io);
+void ioputint (GuestIO * io, int n);
+int iogetint (GuestIO * io, int * n);
+
+static inline void ioputc (GuestIO * io, char c)
+{
+	if (io->len == IOBUFSIZE)
+	{
+		ioflush(io);
+	}
+	io->buf[io->len++] = c;
+}
+
+/*
+ *	Reads one character into c.  Returns 1, or 0 at the end of input
+ *	leaving c as it was.
+ */
+
+static inline int iogetc (GuestIO * io, char * c)
+{
+	int ch;
+
+	if (io->interactive)
+	{
+		ioflush(io);
+		fflush(io->out);
+	}
+	if ((ch = getc_unlocked(io->in)) == EOF)
+	{
+		return 0;
+	}
+	*c = (char) ch;
+	return 1;
+}
+
+#endif
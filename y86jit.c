@@ -0,0 +1,750 @@
+// Ryan Bandilla
+// Y86 Basic Block JIT
+// BKR Comp Arch
+#include <string.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include "y86jit.h"
+#include "y86mem.h"
+
+#ifdef HAVE_JIT
+
+#ifndef JITCODESIZE
+#define JITCODESIZE (16 << 20)		//	Bytes of executable buffer, defined smaller to test flushes
+#endif
+#define JITMAXINSTRS 32				//	Instructions in one block at most
+#define JITMAXBYTES 8192			//	Room a block can need, checked before each
+
+#define JITNONE ((unsigned char *) 1)	//	Block table entry for an address that can't start a block
+
+/*
+ *	Registers the translated code keeps for the whole run
+ *
+ *	rbx - JitState
+ *	r12 - Memory
+ *	r14 - Code marks of the decode cache
+ *	r15 - Block table
+ *
+ *	eax, ecx and edx are scratch.
+ */
+
+#define OFFREG(r) ((unsigned char) (offsetof(JitState, reg) + 4 * (r)))
+#define OFFOF ((unsigned char) offsetof(JitState, OF))
+#define OFFZF ((unsigned char) offsetof(JitState, ZF))
+#define OFFSF ((unsigned char) offsetof(JitState, SF))
+#define OFFPC ((unsigned char) offsetof(JitState, pc))
+#define OFFSTEP ((unsigned char) offsetof(JitState, step))
+#define OFFMEMSIZE ((unsigned char) offsetof(JitState, memsize))
+#define OFFCOUNT ((unsigned char) offsetof(JitState, count))
+#define OFFLIMIT ((unsigned char) offsetof(JitState, limit))
+#define OFFLINK ((unsigned char) offsetof(JitState, link))
+
+typedef void (* JitEnter) (JitState * js, unsigned char * mem, unsigned char * codemap,
+	unsigned char ** blocks, unsigned char * block);
+
+/*
+ *	An exit out of a block that hasn't been emitted yet.  site is the
+ *	rel32 of the jump that goes to it.
+ */
+
+typedef struct
+{
+	unsigned char * site;
+	int step;			//	Stop before the instruction instead of continuing at it
+	unsigned int pc;
+	int done;			//	Instructions executed before leaving
+} Exit;
+
+/*
+	Writing machine code at *p.
+*/
+
+static void emit (unsigned char ** p, const char * bytes, int n)
+{
+	memcpy(*p, bytes, n);
+	*p += n;
+}
+
+static void emit8 (unsigned char ** p, unsigned char b)
+{
+	*(*p)++ = b;
+}
+
+static void emit32 (unsigned char ** p, unsigned int v)
+{
+	memcpy(*p, &v, 4);
+	*p += 4;
+}
+
+static void emit64 (unsigned char ** p, unsigned long long v)
+{
+	memcpy(*p, &v, 8);
+	*p += 8;
+}
+
+/*
+	Points the rel32 at site to target.
+*/
+
+static void patch (unsigned char * site, unsigned char * target)
+{
+	int rel = (int) (target - (site + 4));
+	memcpy(site, &rel, 4);
+}
+
+/*
+	mov r32, [rbx + off] and mov [rbx + off], r32 for eax (0), ecx (1) and
+	edx (2).
+*/
+
+static void load (unsigned char ** p, int r, unsigned char off)
+{
+	emit8(p, 0x8B);
+	emit8(p, 0x43 | r << 3);
+	emit8(p, off);
+}
+
+static void store (unsigned char ** p, int r, unsigned char off)
+{
+	emit8(p, 0x89);
+	emit8(p, 0x43 | r << 3);
+	emit8(p, off);
+}
+
+/*
+	Stores al into a flag as 0 or 1.
+*/
+
+static void setflag (unsigned char ** p, unsigned char off)
+{
+	emit(p, "\x0F\xB6\xC0", 3);		//	movzx eax, al
+	store(p, 0, off);
+}
+
+/*
+	ZF and SF from the result in ecx.
+*/
+
+static void setzs (unsigned char ** p)
+{
+	emit(p, "\x85\xC9", 2);			//	test ecx, ecx
+	emit(p, "\x0F\x94\xC0", 3);		//	sete al
+	setflag(p, OFFZF);
+	emit(p, "\x0F\x98\xC0", 3);		//	sets al
+	setflag(p, OFFSF);
+}
+
+/*
+	Jump with a rel32 to an exit, recorded so it can be filled in when the
+	exits are emitted.  cc is the second opcode byte of a jcc or 0 for jmp.
+*/
+
+static void jumpexit (unsigned char ** p, unsigned char cc, Exit * exits, int * nexits,
+	int step, unsigned int pc, int done)
+{
+	if (cc == 0)
+	{
+		emit8(p, 0xE9);
+	}
+	else
+	{
+		emit8(p, 0x0F);
+		emit8(p, cc);
+	}
+
+	exits[*nexits].site = *p;
+	exits[*nexits].step = step;
+	exits[*nexits].pc = pc;
+	exits[*nexits].done = done;
+	(*nexits)++;
+
+	emit32(p, 0);
+}
+
+/*
+	Checks that the four bytes at the address in eax are inside memory,
+	and with store that none of them has been decoded as code.  Otherwise
+	the interpreter runs the instruction, it reports the bad address or
+	throws away the code being overwritten.
+*/
+
+static void checkaddr (unsigned char ** p, int store, Exit * exits, int * nexits,
+	unsigned int pc, int done)
+{
+	emit(p, "\x48\x8D\x48\x03", 4);		//	lea rcx, [rax + 3]
+	load(p, 2, OFFMEMSIZE);				//	mov edx, memsize
+	emit(p, "\x48\x39\xD1", 3);			//	cmp rcx, rdx
+	jumpexit(p, 0x87, exits, nexits, 1, pc, done);	//	ja
+
+	if (store)
+	{
+		emit(p, "\x41\x8B\x14\x06", 4);	//	mov edx, [r14 + rax]
+		emit(p, "\x85\xD2", 2);			//	test edx, edx
+		jumpexit(p, 0x85, exits, nexits, 1, pc, done);	//	jnz
+	}
+}
+
+/*
+	Leaves eax holding the condition of a jump, nonzero for jle and jl when
+	they are taken and zero for jge and jg when they are taken.
+*/
+
+static void condition (unsigned char ** p, unsigned char op)
+{
+	load(p, 0, OFFSF);
+	emit(p, "\x33\x43", 2);				//	xor eax, OF
+	emit8(p, OFFOF);
+
+	if (op == H_JLE || op == H_JG)
+	{
+		emit(p, "\x0B\x43", 2);			//	or eax, ZF
+		emit8(p, OFFZF);
+	}
+	else
+	{
+		load(p, 1, OFFZF);
+		emit(p, "\x83\xF1\x01", 3);		//	xor ecx, 1
+		emit(p, "\x21\xC8", 2);			//	and eax, ecx
+	}
+}
+
+/*
+	Whether an instruction can be translated.  Register numbers of 8 and up
+	are left to the interpreter, which has always indexed reg[] with them.
+*/
+
+static int translatable (const Decoded * d)
+{
+	switch (d->handler)
+	{
+		case H_NOP:
+		case H_JMP: case H_JLE: case H_JL: case H_JE: case H_JNE: case H_JGE: case H_JG:
+		case H_CALL:
+		case H_RET:
+			return 1;
+
+		case H_IRMOVL:
+			return d->ra >= 8 && d->rb < 8;
+
+		case H_RRMOVL:
+		case H_RMMOVL:
+		case H_MRMOVL:
+		case H_ADDL: case H_SUBL: case H_ANDL: case H_XORL: case H_MULL: case H_CMPL:
+			return d->ra < 8 && d->rb < 8;
+
+		case H_PUSHL:
+		case H_POPL:
+			return d->ra < 8;
+	}
+	return 0;
+}
+
+/*
+	Whether any of the n bytes at addr are on a page whose code has been
+	modified.
+*/
+
+static int isdirty (const Jit * jit, unsigned int addr, unsigned int n)
+{
+	return jit->dirty[addr >> JITPAGESHIFT] || jit->dirty[(addr + n - 1) >> JITPAGESHIFT];
+}
+
+/*
+	Emits the code shared by every block: entering from C with the
+	registers above set up, and going back.
+*/
+
+static void emitentry (Jit * jit)
+{
+	unsigned char * p = jit->code;
+
+	//	void enter (JitState * js, mem, codemap, blocks, block)
+	emit(&p, "\x53\x55\x41\x54\x41\x55\x41\x56\x41\x57", 10);	//	push rbx, rbp, r12-r15
+	emit(&p, "\x48\x83\xEC\x08", 4);			//	sub rsp, 8
+	emit(&p, "\x48\x89\xFB", 3);				//	mov rbx, rdi
+	emit(&p, "\x49\x89\xF4", 3);				//	mov r12, rsi
+	emit(&p, "\x49\x89\xD6", 3);				//	mov r14, rdx
+	emit(&p, "\x49\x89\xCF", 3);				//	mov r15, rcx
+	emit(&p, "\x41\xFF\xE0", 3);				//	jmp r8
+
+	jit->exit = p;
+	emit(&p, "\x48\x83\xC4\x08", 4);			//	add rsp, 8
+	emit(&p, "\x41\x5F\x41\x5E\x41\x5D\x41\x5C\x5D\x5B", 10);	//	pop r15-r12, rbp, rbx
+	emit8(&p, 0xC3);							//	ret
+
+	jit->start = jit->used = p - jit->code;
+}
+
+/*
+	Translates the block starting at pc.  Returns NULL if the first
+	instruction can't be translated.
+*/
+
+static unsigned char * translate (Jit * jit, DecodeCache * dc, const unsigned char * mem, unsigned int pc)
+{
+	Exit exits[3 * JITMAXINSTRS];
+	int nexits = 0;
+	unsigned char * block = jit->code + jit->used;
+	unsigned char * p = block;
+	unsigned int at = pc;
+	int n = 0;
+	int ended = 0;
+	int k;
+
+	//	Leave before running anything once count reaches limit, so a loop
+	//	of linked blocks can't run past the budget
+	emit(&p, "\x48\x8B\x43", 3);			//	mov rax, count
+	emit8(&p, OFFCOUNT);
+	emit(&p, "\x48\x3B\x43", 3);			//	cmp rax, limit
+	emit8(&p, OFFLIMIT);
+	emit(&p, "\x0F\x8D", 2);				//	jge over
+	unsigned char * oversite = p;
+	emit32(&p, 0);
+
+	//	add qword [rbx + count], n, filled in at the end
+	emit(&p, "\x48\x81\x43", 3);
+	emit8(&p, OFFCOUNT);
+	unsigned char * countsite = p;
+	emit32(&p, 0);
+
+	while (!ended && n < JITMAXINSTRS)
+	{
+		if (at >= dc->size || isdirty(jit, at, 1))
+		{
+			break;
+		}
+
+		Decoded * d = &dc->entries[at];
+		if (d->handler == H_DECODE && (d = dcachefill(dc, mem, at)) == NULL)
+		{
+			break;
+		}
+		if (!translatable(d) || isdirty(jit, at, d->len))
+		{
+			break;
+		}
+
+		unsigned int next = at + d->len;
+
+		switch (d->handler)
+		{
+			case H_NOP:
+			break;
+
+			case H_RRMOVL:
+				load(&p, 0, OFFREG(d->ra));
+				store(&p, 0, OFFREG(d->rb));
+			break;
+
+			case H_IRMOVL:
+				emit(&p, "\xC7\x43", 2);			//	mov dword [rbx + rb], imm
+				emit8(&p, OFFREG(d->rb));
+				emit32(&p, d->imm);
+			break;
+
+			case H_RMMOVL:
+			case H_MRMOVL:
+				load(&p, 0, OFFREG(d->rb));
+				emit8(&p, 0x05);					//	add eax, imm
+				emit32(&p, d->imm);
+				checkaddr(&p, d->handler == H_RMMOVL, exits, &nexits, at, n);
+
+				if (d->handler == H_RMMOVL)
+				{
+					load(&p, 1, OFFREG(d->ra));
+					emit(&p, "\x41\x89\x0C\x04", 4);	//	mov [r12 + rax], ecx
+				}
+				else
+				{
+					emit(&p, "\x41\x8B\x0C\x04", 4);	//	mov ecx, [r12 + rax]
+					store(&p, 1, OFFREG(d->ra));
+				}
+			break;
+
+			// OF is only set by an overflow with a nonzero result for addl,
+			// and a nonzero destination for subl and cmpl
+			case H_ADDL:
+			case H_SUBL:
+			case H_CMPL:
+				load(&p, 0, OFFREG(d->ra));
+				load(&p, 1, OFFREG(d->rb));
+
+				if (d->handler == H_ADDL)
+				{
+					emit(&p, "\x01\xC1", 2);		//	add ecx, eax
+					emit(&p, "\x0F\x90\xC0", 3);	//	seto al
+					emit(&p, "\x0F\x95\xC2", 3);	//	setne dl
+				}
+				else
+				{
+					emit(&p, "\x89\xCA", 2);		//	mov edx, ecx
+					emit(&p, "\x29\xC1", 2);		//	sub ecx, eax
+					emit(&p, "\x0F\x90\xC0", 3);	//	seto al
+					emit(&p, "\x85\xD2", 2);		//	test edx, edx
+					emit(&p, "\x0F\x95\xC2", 3);	//	setne dl
+				}
+				emit(&p, "\x20\xD0", 2);			//	and al, dl
+				setflag(&p, OFFOF);
+				setzs(&p);
+
+				if (d->handler != H_CMPL)
+				{
+					store(&p, 1, OFFREG(d->rb));
+				}
+			break;
+
+			// OF is left alone
+			case H_ANDL:
+			case H_XORL:
+				load(&p, 0, OFFREG(d->ra));
+				load(&p, 1, OFFREG(d->rb));
+				emit(&p, d->handler == H_ANDL ? "\x21\xC1" : "\x31\xC1", 2);	//	and/xor ecx, eax
+				setzs(&p);
+				store(&p, 1, OFFREG(d->rb));
+			break;
+
+			// OF when a nonzero product has the wrong sign for its operands
+			case H_MULL:
+				load(&p, 0, OFFREG(d->ra));
+				load(&p, 1, OFFREG(d->rb));
+				emit(&p, "\x89\xC2", 2);			//	mov edx, eax
+				emit(&p, "\x31\xCA", 2);			//	xor edx, ecx
+				emit(&p, "\x0F\xAF\xC8", 3);		//	imul ecx, eax
+				emit(&p, "\x89\xC8", 2);			//	mov eax, ecx
+				emit(&p, "\x31\xD0", 2);			//	xor eax, edx
+				emit(&p, "\xC1\xE8\x1F", 3);		//	shr eax, 31
+				emit(&p, "\x85\xC9", 2);			//	test ecx, ecx
+				emit(&p, "\x0F\x95\xC2", 3);		//	setne dl
+				emit(&p, "\x20\xD0", 2);			//	and al, dl
+				setflag(&p, OFFOF);
+				setzs(&p);
+				store(&p, 1, OFFREG(d->rb));
+			break;
+
+			case H_JMP:
+				jumpexit(&p, 0, exits, &nexits, 0, d->imm, n + 1);
+				ended = 1;
+			break;
+
+			case H_JE:
+			case H_JNE:
+				emit(&p, "\x83\x7B", 2);			//	cmp dword ZF, 0
+				emit8(&p, OFFZF);
+				emit8(&p, 0);
+				jumpexit(&p, d->handler == H_JE ? 0x85 : 0x84, exits, &nexits, 0, d->imm, n + 1);
+				jumpexit(&p, 0, exits, &nexits, 0, next, n + 1);
+				ended = 1;
+			break;
+
+			case H_JLE:
+			case H_JL:
+			case H_JGE:
+			case H_JG:
+				condition(&p, d->handler);
+				jumpexit(&p, d->handler == H_JLE || d->handler == H_JL ? 0x85 : 0x84,
+					exits, &nexits, 0, d->imm, n + 1);
+				jumpexit(&p, 0, exits, &nexits, 0, next, n + 1);
+				ended = 1;
+			break;
+
+			case H_CALL:
+			case H_PUSHL:
+				load(&p, 0, OFFREG(4));
+				emit(&p, "\x83\xE8\x04", 3);		//	sub eax, 4
+				checkaddr(&p, 1, exits, &nexits, at, n);
+
+				if (d->handler == H_CALL)
+				{
+					emit(&p, "\x41\xC7\x04\x04", 4);	//	mov dword [r12 + rax], next
+					emit32(&p, next);
+				}
+				else
+				{
+					//	pushl %esp pushes the value after the decrement
+					if (d->ra == 4)
+					{
+						emit(&p, "\x89\xC1", 2);	//	mov ecx, eax
+					}
+					else
+					{
+						load(&p, 1, OFFREG(d->ra));
+					}
+					emit(&p, "\x41\x89\x0C\x04", 4);	//	mov [r12 + rax], ecx
+				}
+				store(&p, 0, OFFREG(4));
+
+				if (d->handler == H_CALL)
+				{
+					jumpexit(&p, 0, exits, &nexits, 0, d->imm, n + 1);
+					ended = 1;
+				}
+			break;
+
+			case H_POPL:
+			case H_RET:
+				load(&p, 0, OFFREG(4));
+				checkaddr(&p, 0, exits, &nexits, at, n);
+				emit(&p, "\x41\x8B\x0C\x04", 4);	//	mov ecx, [r12 + rax]
+				if (d->handler == H_POPL)
+				{
+					store(&p, 1, OFFREG(d->ra));
+				}
+				emit(&p, "\x83\x43", 2);			//	add dword [rbx + esp], 4
+				emit8(&p, OFFREG(4));
+				emit8(&p, 4);
+
+				if (d->handler == H_RET)
+				{
+					//	Straight to the block for the return address if it
+					//	has one, otherwise back to jitrun()
+					store(&p, 1, OFFPC);
+					emit(&p, "\x89\xC8", 2);			//	mov eax, ecx
+					emit(&p, "\x3B\x43", 2);			//	cmp eax, memsize
+					emit8(&p, OFFMEMSIZE);
+					emit(&p, "\x73\x0C", 2);			//	jae miss
+					emit(&p, "\x49\x8B\x0C\xC7", 4);	//	mov rcx, [r15 + rax * 8]
+					emit(&p, "\x48\x83\xF9\x01", 4);	//	cmp rcx, 1
+					emit(&p, "\x76\x02", 2);			//	jbe miss
+					emit(&p, "\xFF\xE1", 2);			//	jmp rcx
+					emit(&p, "\x48\xC7\x43", 3);		//	miss: mov qword link, 0
+					emit8(&p, OFFLINK);
+					emit32(&p, 0);
+					emit8(&p, 0xE9);					//	jmp exit
+					patch(p, jit->exit);
+					p += 4;
+					ended = 1;
+				}
+			break;
+		}
+
+		n++;
+		at = next;
+	}
+
+	if (n == 0)
+	{
+		return NULL;
+	}
+
+	if (!ended)
+	{
+		jumpexit(&p, 0, exits, &nexits, 0, at, n);
+	}
+	memcpy(countsite, &n, 4);
+
+	//	The exits, out of the way of the straight line code
+	for (k = 0; k < nexits; k++)
+	{
+		patch(exits[k].site, p);
+
+		if (exits[k].step)
+		{
+			emit(&p, "\x48\x81\x6B", 3);		//	sub qword count, instructions not run
+			emit8(&p, OFFCOUNT);
+			emit32(&p, n - exits[k].done);
+			emit(&p, "\xC7\x43", 2);			//	mov dword step, 1
+			emit8(&p, OFFSTEP);
+			emit32(&p, 1);
+			emit(&p, "\x48\xC7\x43", 3);		//	mov qword link, 0
+			emit8(&p, OFFLINK);
+			emit32(&p, 0);
+		}
+		else
+		{
+			//	A jump jitlink() can point at the next block
+			unsigned char * site = p;
+			emit8(&p, 0xE9);
+			emit32(&p, 0);
+			patch(site + 1, p);
+
+			if (exits[k].done != n)
+			{
+				emit(&p, "\x48\x81\x6B", 3);
+				emit8(&p, OFFCOUNT);
+				emit32(&p, n - exits[k].done);
+			}
+			emit(&p, "\x48\xB8", 2);			//	mov rax, site
+			emit64(&p, (unsigned long long) site);
+			emit(&p, "\x48\x89\x43", 3);		//	mov qword link, rax
+			emit8(&p, OFFLINK);
+		}
+
+		emit(&p, "\xC7\x43", 2);				//	mov dword pc, exit pc
+		emit8(&p, OFFPC);
+		emit32(&p, exits[k].pc);
+		emit8(&p, 0xE9);						//	jmp exit
+		patch(p, jit->exit);
+		p += 4;
+	}
+
+	//	over: back to jitrun() with pc at the block
+	patch(oversite, p);
+	emit(&p, "\xC7\x43", 2);					//	mov dword pc, block pc
+	emit8(&p, OFFPC);
+	emit32(&p, pc);
+	emit(&p, "\x48\xC7\x43", 3);				//	mov qword link, 0
+	emit8(&p, OFFLINK);
+	emit32(&p, 0);
+	emit8(&p, 0xE9);							//	jmp exit
+	patch(p, jit->exit);
+	p += 4;
+
+	jit->used = p - jit->code;
+	jit->translated++;
+	return block;
+}
+
+/*
+	Throws away every translated block.
+*/
+
+static void flush (Jit * jit)
+{
+	memfree((unsigned char *) jit->blocks, (size_t) jit->size * sizeof(unsigned char *));
+	jit->blocks = (unsigned char **) memalloc((size_t) jit->size * sizeof(unsigned char *), 1);
+	jit->used = jit->start;
+	jit->flushes++;
+}
+
+/*
+	Sets up the buffer and tables for size bytes of memory.
+	Returns 0 on success and -1 if they can't be mapped.
+*/
+
+int jitinit (Jit * jit, unsigned int size)
+{
+	memset(jit, 0, sizeof(Jit));
+
+	void * code = mmap(NULL, JITCODESIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (code == MAP_FAILED)
+	{
+		return -1;
+	}
+
+	jit->code = (unsigned char *) code;
+	jit->codesize = JITCODESIZE;
+	jit->size = size;
+	jit->blocks = (unsigned char **) memalloc((size_t) size * sizeof(unsigned char *), 1);
+	jit->dirty = memalloc(((size_t) size >> JITPAGESHIFT) + 1, 1);
+
+	if (jit->blocks == NULL || jit->dirty == NULL)
+	{
+		jitfree(jit);
+		return -1;
+	}
+
+	emitentry(jit);
+	return 0;
+}
+
+/*
+	Releases the buffer and tables.  The counters are kept so they can be
+	reported after the run.
+*/
+
+void jitfree (Jit * jit)
+{
+	if (jit->code != NULL)
+	{
+		munmap(jit->code, jit->codesize);
+	}
+	if (jit->blocks != NULL)
+	{
+		memfree((unsigned char *) jit->blocks, (size_t) jit->size * sizeof(unsigned char *));
+	}
+	if (jit->dirty != NULL)
+	{
+		memfree(jit->dirty, ((size_t) jit->size >> JITPAGESHIFT) + 1);
+	}
+	jit->code = NULL;
+	jit->blocks = NULL;
+	jit->dirty = NULL;
+}
+
+/*
+	The block starting at pc, translated the first time it is asked for.
+	Returns NULL when the instruction at pc has to be interpreted.
+*/
+
+unsigned char * jitblock (Jit * jit, DecodeCache * dc, const unsigned char * mem, int pc)
+{
+	unsigned int at = (unsigned int) pc;
+
+	if (at >= jit->size)
+	{
+		return NULL;
+	}
+
+	unsigned char * block = jit->blocks[at];
+	if (block == JITNONE)
+	{
+		return NULL;
+	}
+	if (block != NULL)
+	{
+		return block;
+	}
+
+	if (jit->codesize - jit->used < JITMAXBYTES)
+	{
+		flush(jit);
+	}
+
+	block = translate(jit, dc, mem, at);
+	jit->blocks[at] = block != NULL ? block : JITNONE;
+	return block;
+}
+
+/*
+	Runs translated code from block until it leaves for an address
+	without a block, an instruction it can't run, or an instruction the
+	interpreter has to run (js->step).
+*/
+
+void jitrun (Jit * jit, JitState * js, unsigned char * block, unsigned char * mem,
+	unsigned char * codemap)
+{
+	JitEnter enter = (JitEnter) (void *) jit->code;
+
+	js->step = 0;
+	js->link = NULL;
+	js->flushes = jit->flushes;
+	enter(js, mem, codemap, jit->blocks, block);
+}
+
+/*
+	Chains the exit the code last left through straight to block.  Not
+	if finding block flushed the code the exit was in, its bytes may now
+	be part of block or any other.
+*/
+
+void jitlink (Jit * jit, JitState * js, unsigned char * block)
+{
+	if (js->link != NULL && block != NULL && js->flushes == jit->flushes)
+	{
+		patch(js->link + 1, block);
+	}
+	js->link = NULL;
+}
+
+/*
+	Called after the program stores into n bytes of code at addr.  Their
+	pages are left to the interpreter from now on and every block is
+	thrown away, as any of them could have run through the old code.
+*/
+
+void jitmodified (Jit * jit, unsigned int addr, unsigned int n)
+{
+	unsigned int first = addr >> JITPAGESHIFT;
+	unsigned int last = (addr + n - 1) >> JITPAGESHIFT;
+	unsigned int k;
+
+	for (k = first; k <= last && k <= jit->size >> JITPAGESHIFT; k++)
+	{
+		jit->dirty[k] = 1;
+	}
+	flush(jit);
+}
+
+#endif
@@ -0,0 +1,82 @@
+// Ryan Bandilla
+// Y86 Basic Block JIT
+// BKR Comp Arch
+#ifndef Y86JIT_H
+#define Y86JIT_H
+
+#include <stddef.h>
+#include "y86decode.h"
+
+/*
+ *	Translates Y86 basic blocks to x86-64 machine code.  Only built on
+ *	x86-64 hosts, define Y86_NOJIT to leave it out.
+ */
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(Y86_NOJIT)
+#define HAVE_JIT 1
+#endif
+
+/*
+ *	Machine state the translated code runs on, copied in and out of
+ *	run()'s locals around each run.
+ *
+ *	step  - Set when the code stopped before the instruction at pc because
+ *	        the interpreter has to run it (a store into code, an address
+ *	        outside of memory)
+ *	link  - The jump that led out of the code, so it can be pointed
+ *	        straight at the block for pc once there is one
+ *	count - Instructions executed
+ *	limit - count at which a block leaves instead of running, checked as
+ *	        each block is entered
+ *	flushes - Jit flushes when the code was entered; once they change
+ *	          link points into code that has been thrown away
+ */
+
+typedef struct
+{
+	int reg[8];
+	int OF, ZF, SF;
+	int pc;
+	int step;
+	unsigned int memsize;
+	long long count;
+	long long limit;
+	unsigned char * link;
+	long long flushes;
+} JitState;
+
+/*
+ *	Translated blocks live in one executable buffer, found through a table
+ *	with an entry for every address.  Memory is split into JITPAGE byte
+ *	pages; once the program stores into code on a page nothing on that
+ *	page is translated again and it is left to the interpreter.
+ */
+
+#define JITPAGESHIFT 8
+
+typedef struct
+{
+	unsigned char * code;		//	Executable buffer
+	size_t codesize;
+	size_t used;				//	Bytes of it holding code
+	size_t start;				//	First byte after the entry and exit code
+
+	unsigned char ** blocks;	//	Block for each address, NULL or JITNONE
+	unsigned char * dirty;		//	Pages whose code has been modified
+	unsigned int size;			//	Bytes of memory
+
+	unsigned char * exit;		//	Returns from jitrun()
+
+	long long translated;		//	Blocks translated
+	long long flushes;			//	Times every block was thrown away
+} Jit;
+
+int jitinit (Jit * jit, unsigned int size);
+void jitfree (Jit * jit);
+unsigned char * jitblock (Jit * jit, DecodeCache * dc, const unsigned char * mem, int pc);
+void jitrun (Jit * jit, JitState * js, unsigned char * block, unsigned char * mem,
+	unsigned char * codemap);
+void jitlink (Jit * jit, JitState * js, unsigned char * block);
+void jitmodified (Jit * jit, unsigned int addr, unsigned int n);
+
+#endif
@@ -0,0 +1,368 @@
+// Ryan Bandilla
+// Y86 Loader
+// BKR Comp Arch
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "y86load.h"
+#include "y86hex.h"
+
+#define READCHUNK (1 << 20)
+
+/*
+	Seconds on a monotonic clock, used to time the load.
+*/
+
+static double now ()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+	Reads the rest of fd into a malloc'd buffer, READCHUNK bytes at a time.
+	The buffer doubles when it fills up so the whole read stays linear.
+*/
+
+static int readall (int fd, Source * src)
+{
+	size_t cap = READCHUNK;
+	size_t len = 0;
+	char * buf = (char *) malloc(cap);
+
+	if (buf == NULL)
+	{
+		return -1;
+	}
+
+	while (1)
+	{
+		if (cap - len < READCHUNK)
+		{
+			char * grown = (char *) realloc(buf, 2 * cap);
+			if (grown == NULL)
+			{
+				free(buf);
+				return -1;
+			}
+			buf = grown;
+			cap *= 2;
+		}
+
+		ssize_t got = read(fd, buf + len, cap - len);
+		if (got < 0)
+		{
+			free(buf);
+			return -1;
+		}
+		if (got == 0)
+		{
+			break;
+		}
+		len += got;
+	}
+
+	src->text = buf;
+	src->length = len;
+	src->mapsize = 0;
+	return 0;
+}
+
+/*
+	Maps a regular file read only.
+*/
+
+static int mapfile (int fd, size_t len, Source * src)
+{
+	if (len == 0)
+	{
+		return -1;
+	}
+
+	void * text = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (text == MAP_FAILED)
+	{
+		return -1;
+	}
+	madvise(text, len, MADV_SEQUENTIAL);
+
+	src->text = (const char *) text;
+	src->length = len;
+	src->mapsize = len;
+	return 0;
+}
+
+/*
+	Returns the next token at or after *cursor and its length, or NULL at
+	the end of the text.  Tokens are separated by newlines, tabs and
+	carriage returns, the same tokens strtok(text, "\n\t\r") produces.
+*/
+
+static const char * nexttoken (const char ** cursor, const char * end, unsigned int * len)
+{
+	const char * p = *cursor;
+
+	while (p < end && (*p == '\n' || *p == '\t' || *p == '\r'))
+	{
+		p++;
+	}
+	if (p == end)
+	{
+		*cursor = p;
+		return NULL;
+	}
+
+	const char * tok = p;
+	while (p < end && *p != '\n' && *p != '\t' && *p != '\r')
+	{
+		p++;
+	}
+
+	*cursor = p;
+	*len = p - tok;
+	return tok;
+}
+
+/*
+	Works out which directive a token names.
+*/
+
+static DirectiveKind directivekind (const char * tok, unsigned int len)
+{
+	static const struct { const char * name; DirectiveKind kind; } names[] =
+	{
+		{ ".size", DIR_SIZE },
+		{ ".text", DIR_TEXT },
+		{ ".byte", DIR_BYTE },
+		{ ".long", DIR_LONG },
+		{ ".string", DIR_STRING },
+		{ ".bss", DIR_BSS }
+	};
+	int i;
+
+	for (i = 0; i < (int) (sizeof(names) / sizeof(names[0])); i++)
+	{
+		if (strlen(names[i].name) == len && memcmp(names[i].name, tok, len) == 0)
+		{
+			return names[i].kind;
+		}
+	}
+	return DIR_INVALID;
+}
+
+/*
+	Scans the text once and records every directive with its operands.
+	Tokens that aren't directives or operands are ignored, as they always
+	have been.  A directive missing its operands is recorded as invalid.
+*/
+
+static int parse (Source * src)
+{
+	int cap = 256;
+	Directive * dirs = (Directive *) malloc(cap * sizeof(Directive));
+	int n = 0;
+	const char * p = src->text;
+	const char * end = src->text + src->length;
+	const char * tok;
+	unsigned int len;
+
+	if (dirs == NULL)
+	{
+		return -1;
+	}
+
+	while ((tok = nexttoken(&p, end, &len)) != NULL)
+	{
+		if (tok[0] != '.')
+		{
+			continue;
+		}
+
+		if (n == cap)
+		{
+			Directive * grown = (Directive *) realloc(dirs, 2 * cap * sizeof(Directive));
+			if (grown == NULL)
+			{
+				free(dirs);
+				return -1;
+			}
+			dirs = grown;
+			cap *= 2;
+		}
+
+		Directive * d = &dirs[n++];
+		d->kind = directivekind(tok, len);
+		d->payload = tok;
+		d->length = len;
+		d->address = 0;
+
+		if (d->kind == DIR_SIZE)
+		{
+			const char * arg = nexttoken(&p, end, &len);
+			if (arg == NULL)
+			{
+				d->kind = DIR_INVALID;
+				break;
+			}
+			d->address = hextodec(arg, len);
+			d->payload = arg;
+			d->length = len;
+		}
+		else if (d->kind != DIR_BSS && d->kind != DIR_INVALID)
+		{
+			unsigned int alen;
+			const char * address = nexttoken(&p, end, &alen);
+			const char * arg = address != NULL ? nexttoken(&p, end, &len) : NULL;
+			if (arg == NULL)
+			{
+				d->kind = DIR_INVALID;
+				break;
+			}
+			d->address = hextodec(address, alen);
+			d->payload = arg;
+			d->length = len;
+		}
+	}
+
+	src->dirs = dirs;
+	src->ndirs = n;
+	return 0;
+}
+
+/*
+	Maps or reads the named file without parsing it.
+	Returns 0 on success and -1 if the file can't be opened or read.
+*/
+
+int readsource (const char * name, Source * src)
+{
+	double start = now();
+	struct stat st;
+
+	memset(src, 0, sizeof(Source));
+
+	int fd = open(name, O_RDONLY);
+	if (fd < 0)
+	{
+		return -1;
+	}
+
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || mapfile(fd, st.st_size, src) != 0)
+	{
+		if (readall(fd, src) != 0)
+		{
+			close(fd);
+			return -1;
+		}
+	}
+	close(fd);
+
+	src->loadtime = now() - start;
+	return 0;
+}
+
+/*
+	Records the directives of a source read with readsource().
+*/
+
+int parsesource (Source * src)
+{
+	double start = now();
+
+	if (parse(src) != 0)
+	{
+		return -1;
+	}
+
+	src->loadtime += now() - start;
+	return 0;
+}
+
+/*
+	Loads and parses the named file.
+	Returns 0 on success and -1 if the file can't be opened or read.
+*/
+
+int loadsource (const char * name, Source * src)
+{
+	if (readsource(name, src) != 0)
+	{
+		return -1;
+	}
+	if (parsesource(src) != 0)
+	{
+		freesource(src);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+	Releases the text and directive table of a loaded source.
+*/
+
+void freesource (Source * src)
+{
+	if (src->mapsize != 0)
+	{
+		munmap((void *) src->text, src->mapsize);
+	}
+	else
+	{
+		free((void *) src->text);
+	}
+	free(src->dirs);
+	memset(src, 0, sizeof(Source));
+}
+
+/*
+	Value of a .byte (hex) or .long (decimal, read like atoi) operand.
+*/
+
+int directivevalue (const Directive * dir)
+{
+	const char * p = dir->payload;
+	const char * end = p + dir->length;
+	unsigned int ret = 0;
+	int negative = 0;
+
+	if (dir->kind == DIR_BYTE)
+	{
+		return hextodec(p, dir->length);
+	}
+
+	while (p < end && *p == ' ')
+	{
+		p++;
+	}
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+	for (; p < end && *p >= '0' && *p <= '9'; p++)
+	{
+		ret = ret * 10 + (*p - '0');
+	}
+	return (int) (negative ? 0u - ret : ret);
+}
+
+/*
+	Reports how long the load took and the resulting throughput.
+*/
+
+void printloadstats (FILE * out, const Source * src)
+{
+	double mb = src->length / (1024.0 * 1024.0);
+	double rate = src->loadtime > 0 ? mb / src->loadtime : 0;
+
+	fprintf(out, "Loaded %zu bytes, %d directives in %.3f ms (%.1f MB/s, %s)\n",
+		src->length, src->ndirs, src->loadtime * 1000, rate,
+		src->mapsize != 0 ? "mapped" : "read");
+}
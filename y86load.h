@@ -0,0 +1,67 @@
+// Ryan Bandilla
+// Y86 Loader
+// BKR Comp Arch
+#ifndef Y86LOAD_H
+#define Y86LOAD_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/*
+ *	Directives that can appear in a .y86 file
+ */
+
+typedef enum
+{
+	DIR_SIZE,		//	.size	<hex size>
+	DIR_TEXT,		//	.text	<hex address>	<hex instructions>
+	DIR_BYTE,		//	.byte	<hex address>	<hex byte>
+	DIR_LONG,		//	.long	<hex address>	<decimal integer>
+	DIR_STRING,		//	.string	<hex address>	"<characters>"
+	DIR_BSS,		//	.bss, not used
+	DIR_INVALID		//	Unknown directive or one missing its operands
+} DirectiveKind;
+
+/*
+ *	One directive found in the file.
+ *	The payload is a span of the file text, nothing is copied out of it.
+ *	For .size the address holds the size, for an invalid directive the
+ *	payload is the offending token.
+ */
+
+typedef struct
+{
+	const char * payload;
+	unsigned int length;
+	unsigned int address;
+	unsigned char kind;
+} Directive;
+
+/*
+ *	A .y86 program file held in memory and parsed into directives.
+ *
+ *	The file is mapped read only (or read in large blocks when it can't be
+ *	mapped) and scanned once.  The text is not '\0' terminated, every
+ *	payload is a pointer and length into it.
+ */
+
+typedef struct
+{
+	const char * text;	//	File contents
+	size_t length;		//	Length of the file in bytes
+	size_t mapsize;		//	Size of the mapping, 0 if text was malloc'd
+
+	Directive * dirs;	//	Directives in file order
+	int ndirs;
+
+	double loadtime;	//	Seconds spent reading and parsing the file
+} Source;
+
+int loadsource (const char * name, Source * src);
+int readsource (const char * name, Source * src);
+int parsesource (Source * src);
+void freesource (Source * src);
+int directivevalue (const Directive * dir);
+void printloadstats (FILE * out, const Source * src);
+
+#endif
@@ -0,0 +1,331 @@
+// Ryan Bandilla
+// Y86 Loader Benchmark
+// BKR Comp Arch
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "y86load.h"
+#include "y86hex.h"
+#include "y86mem.h"
+#include "y86vm.h"
+
+/*
+	Times each phase of loading a .y86 file, the best of a few repeats,
+	and prints one tab separated line per file and phase:
+
+		file bytes phase ms mb_per_s allocs allocs_per_mb
+
+	read     - Mapping or reading the file, readsource(), and for a
+	           mapped file touching each of its pages so they are read in
+	tokenize - Scanning it into directives, parsesource()
+	decode   - The .text hex into a buffer of its own, as y86dis does
+	alloc    - Mapping and releasing the .size bytes of memory alone
+	populate - Sizing memory and applying every directive, vmloadsource()
+	y86emul  - read, tokenize and populate, the emulator's load
+	y86dis   - read, tokenize and decode, the disassembler's load
+
+	MB are of the file.  Allocations are the malloc, calloc and realloc
+	calls of the phase; memory mapped for guest memory and the decode
+	cache isn't counted.  Files of growing size come from y86gen, e.g.
+
+		for n in 1m 16m 128m; do ./y86gen -t $n -l 64k -o gen$n.y86; done
+		./y86loadbench gen*.y86
+*/
+
+typedef enum
+{
+	PHASE_READ,
+	PHASE_TOKENIZE,
+	PHASE_DECODE,
+	PHASE_ALLOC,
+	PHASE_POPULATE,
+	PHASES
+} Phase;
+
+static const char * phasename[PHASES] = { "read", "tokenize", "decode", "alloc", "populate" };
+
+typedef struct
+{
+	double secs;
+	long long allocs;
+} Sample;
+
+static long long allocs;		//	Heap allocations so far, on glibc
+
+#ifdef __GLIBC__
+extern void * __libc_malloc (size_t n);
+extern void * __libc_calloc (size_t n, size_t size);
+extern void * __libc_realloc (void * p, size_t n);
+
+/*
+	Every heap allocation of the process comes through these on glibc,
+	counted and handed on.
+*/
+
+void * malloc (size_t n)
+{
+	allocs++;
+	return __libc_malloc(n);
+}
+
+void * calloc (size_t n, size_t size)
+{
+	allocs++;
+	return __libc_calloc(n, size);
+}
+
+void * realloc (void * p, size_t n)
+{
+	allocs++;
+	return __libc_realloc(p, n);
+}
+#define COUNTALLOCS 1
+#else
+#define COUNTALLOCS 0
+#endif
+
+/*
+	Seconds on a monotonic clock.
+*/
+
+static double now ()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+	Starts timing a phase.
+*/
+
+static void begin (Sample * s)
+{
+	s->allocs = allocs;
+	s->secs = now();
+}
+
+/*
+	Ends the phase begun on s and keeps it in best if it was quicker.
+*/
+
+static void end (Sample * s, Sample * best)
+{
+	s->secs = now() - s->secs;
+	s->allocs = allocs - s->allocs;
+	if (best->secs < 0 || s->secs < best->secs)
+	{
+		*best = *s;
+	}
+}
+
+/*
+	Reads in every page of a mapped source, so the cost of paging it in
+	is timed with the read and not with whatever looks at it first.
+*/
+
+static void touchsource (const Source * src)
+{
+	volatile unsigned char sum = 0;
+	long page = sysconf(_SC_PAGESIZE);
+	size_t i;
+
+	if (page <= 0)
+	{
+		page = 4096;
+	}
+	for (i = 0; i < src->length; i += (size_t) page)
+	{
+		sum += (unsigned char) src->text[i];
+	}
+	(void) sum;
+}
+
+/*
+	One load of name through every phase into best.  Returns 0, or -1
+	if the file can't be loaded.
+*/
+
+static int loadonce (const char * name, Sample * best, size_t * bytes)
+{
+	Source src;
+	Sample s;
+	VM * vm;
+	unsigned char * buf;
+	unsigned char * mem;
+	unsigned int size = 0;
+	int i;
+
+	begin(&s);
+	if (readsource(name, &src) != 0)
+	{
+		return -1;
+	}
+	if (src.mapsize != 0)
+	{
+		touchsource(&src);
+	}
+	end(&s, &best[PHASE_READ]);
+	*bytes = src.length;
+
+	begin(&s);
+	if (parsesource(&src) != 0)
+	{
+		freesource(&src);
+		return -1;
+	}
+	end(&s, &best[PHASE_TOKENIZE]);
+
+	begin(&s);
+	for (i = 0; i < src.ndirs; i++)
+	{
+		if (src.dirs[i].kind == DIR_TEXT)
+		{
+			buf = (unsigned char *) malloc((src.dirs[i].length + 1) / 2);
+			if (buf != NULL)
+			{
+				hextobytes(src.dirs[i].payload, src.dirs[i].length, buf);
+			}
+			free(buf);
+		}
+		else if (src.dirs[i].kind == DIR_SIZE)
+		{
+			size = src.dirs[i].address;
+		}
+	}
+	end(&s, &best[PHASE_DECODE]);
+
+	begin(&s);
+	if ((mem = memalloc(size, 0)) != NULL)
+	{
+		memfree(mem, size);
+	}
+	end(&s, &best[PHASE_ALLOC]);
+
+	begin(&s);
+	if ((vm = vmcreate()) == NULL || vmloadsource(vm, &src) != 0)
+	{
+		vmdestroy(vm);
+		freesource(&src);
+		return -1;
+	}
+	end(&s, &best[PHASE_POPULATE]);
+
+	vmdestroy(vm);
+	freesource(&src);
+	return 0;
+}
+
+/*
+	Prints the line of one phase, or of the sum of the phases set in
+	sum, of a file of bytes bytes.
+*/
+
+static void printphase (const char * name, size_t bytes, const char * phase, const Sample * best, const int * sum)
+{
+	double mb = bytes / (1024.0 * 1024.0);
+	double secs = 0;
+	long long n = 0;
+	int i;
+
+	for (i = 0; i < PHASES; i++)
+	{
+		if (sum[i])
+		{
+			secs += best[i].secs;
+			n += best[i].allocs;
+		}
+	}
+	printf("%s\t%zu\t%s\t%.3f\t%.1f\t", name, bytes, phase, secs * 1000, secs > 0 ? mb / secs : 0);
+	if (COUNTALLOCS)
+	{
+		printf("%lld\t%.1f\n", n, mb > 0 ? n / mb : 0);
+	}
+	else
+	{
+		printf("-\t-\n");
+	}
+}
+
+int main (int argc, char ** argv)
+{
+	static const int emul[PHASES] = { 1, 1, 0, 0, 1 };
+	static const int dis[PHASES] = { 1, 1, 1, 0, 0 };
+	int repeats = 3;			//	Loads of each file, the best is kept, -r
+	int failed = 0;
+	int opt, i, k, p;
+
+	while ((opt = getopt(argc, argv, "hr:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'h':
+				printf("Times each phase of loading Y86 files and prints their throughput.\n");
+				printf("Usage: \n");
+				printf("./y86loadbench [-r repeats] <y86 file name>...\n");
+				printf("\t-r\tloads of each file, the quickest of each phase is kept, 3 by default\n");
+				printf("Prints file, bytes, phase, ms, mb_per_s, allocs and allocs_per_mb separated by tabs,\n");
+				printf("one line per file and phase: read, tokenize, decode, alloc, populate, y86emul, y86dis\n");
+				return 0;
+
+			case 'r':
+				repeats = atoi(optarg);
+			break;
+
+			default:
+				fprintf(stderr, "ERROR: Invalid option, see -h\n");
+				return 1;
+		}
+	}
+
+	if (optind >= argc)
+	{
+		fprintf(stderr, "ERROR: Missing file name, see -h\n");
+		return 1;
+	}
+	if (repeats < 1)
+	{
+		fprintf(stderr, "ERROR: Invalid repeats: %d\n", repeats);
+		return 1;
+	}
+
+	printf("file\tbytes\tphase\tms\tmb_per_s\tallocs\tallocs_per_mb\n");
+	for (i = optind; i < argc; i++)
+	{
+		Sample best[PHASES];
+		size_t bytes = 0;
+
+		for (p = 0; p < PHASES; p++)
+		{
+			best[p].secs = -1;
+			best[p].allocs = 0;
+		}
+		for (k = 0; k < repeats; k++)
+		{
+			if (loadonce(argv[i], best, &bytes) != 0)
+			{
+				break;
+			}
+		}
+		if (k < repeats)
+		{
+			fprintf(stderr, "ERROR: Could not load %s\n", argv[i]);
+			failed = 1;
+			continue;
+		}
+
+		for (p = 0; p < PHASES; p++)
+		{
+			int one[PHASES] = { 0, 0, 0, 0, 0 };
+
+			one[p] = 1;
+			printphase(argv[i], bytes, phasename[p], best, one);
+		}
+		printphase(argv[i], bytes, "y86emul", best, emul);
+		printphase(argv[i], bytes, "y86dis", best, dis);
+		fflush(stdout);
+	}
+	return failed;
+}
@@ -0,0 +1,324 @@
+// Ryan Bandilla
+// Y86 Guest Memory
+// BKR Comp Arch
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "y86mem.h"
+
+#define GUARDPAGES 4			//	Pages one instruction can fault on, at most
+
+/*
+	What the running thread's guarded memory does with a fault, see
+	guardbegin()
+*/
+
+static __thread struct
+{
+	unsigned char * mem;
+	volatile int * status;
+	int fault;
+	int faulted;
+	unsigned int addr;
+	unsigned char * pages[GUARDPAGES];
+	int npages;
+} guard;
+
+static pthread_once_t guardonce = PTHREAD_ONCE_INIT;
+static struct sigaction guardprev;
+static int guardinstalled;
+static long guardpage;
+
+/*
+	Maps size bytes of demand-zero memory, plus the one spare byte the
+	emulator has always allocated past the end.  With noreserve the kernel
+	doesn't set aside swap for the whole mapping either, so sizes larger
+	than the machine can back still load.  Nothing past the spare byte is
+	mapped, the handlers check every access against the size first.
+	Returns NULL if the mapping fails.
+*/
+
+unsigned char * memalloc (size_t size, int noreserve)
+{
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+	if (noreserve)
+	{
+		flags |= MAP_NORESERVE;
+	}
+
+	void * mem = mmap(NULL, size + 1, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (mem == MAP_FAILED)
+	{
+		return NULL;
+	}
+	return (unsigned char *) mem;
+}
+
+/*
+	Zeroes memory from memalloc() or memguard(), and the spare byte, by
+	mapping fresh demand-zero pages over it.  This costs releasing the
+	pages that had been touched, not the size.
+	Returns -1 if the mapping fails, the memory is then unusable.
+*/
+
+int memclear (unsigned char * mem, size_t size, int noreserve)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	unsigned char * first = (unsigned char *) ((uintptr_t) mem & ~(uintptr_t) (page - 1));
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED;
+
+	if (noreserve)
+	{
+		flags |= MAP_NORESERVE;
+	}
+
+	// Guarded memory starts part way into its first page, the bytes of
+	// the page before it are unused
+	if (mmap(first, mem + size + 1 - first, PROT_READ | PROT_WRITE, flags, -1, 0) == MAP_FAILED)
+	{
+		return -1;
+	}
+	return 0;
+}
+
+/*
+	Releases memory from memalloc().
+*/
+
+void memfree (unsigned char * mem, size_t size)
+{
+	munmap(mem, size + 1);
+}
+
+/*
+	Bytes of the window before guarded memory of size bytes, so the spare
+	byte past the end is the last byte of a page and the first bad address
+	is the first byte of the next.
+*/
+
+static size_t guardlead (size_t size, long page)
+{
+	return (page - (size + 1) % page) % page;
+}
+
+/*
+	Reserves the window for guarded memory of size bytes and makes the
+	memory itself usable, as memalloc() would.  Reserving the window costs
+	address space only.
+	Returns NULL if the window can't be reserved.
+*/
+
+unsigned char * memguard (size_t size, int noreserve)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	size_t lead = guardlead(size, page);
+	size_t total = lead + GUARDWINDOW + page;
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED;
+
+	if (noreserve)
+	{
+		flags |= MAP_NORESERVE;
+	}
+
+	unsigned char * base = (unsigned char *) mmap(NULL, total, PROT_NONE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (base == MAP_FAILED)
+	{
+		return NULL;
+	}
+	if (mmap(base, lead + size + 1, PROT_READ | PROT_WRITE, flags, -1, 0) == MAP_FAILED)
+	{
+		munmap(base, total);
+		return NULL;
+	}
+	return base + lead;
+}
+
+/*
+	Releases memory from memguard() and its window.
+*/
+
+void memunguard (unsigned char * mem, size_t size)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	size_t lead = guardlead(size, page);
+
+	munmap(mem - lead, lead + GUARDWINDOW + page);
+}
+
+/*
+	SIGSEGV handler.  A fault inside the window of the thread's guarded
+	memory opens the page up, so the access can complete, and sets the
+	status.  Any other fault goes back to the handler there was before, by
+	returning and faulting again.
+*/
+
+static void guardfault (int sig, siginfo_t * info, void * context)
+{
+	unsigned char * a = (unsigned char *) info->si_addr;
+
+	(void) sig;
+	(void) context;
+
+	if (guard.mem != NULL && a >= guard.mem && a < guard.mem + GUARDWINDOW + GUARDSLACK &&
+		guard.npages < GUARDPAGES)
+	{
+		unsigned char * page = (unsigned char *) ((uintptr_t) a & ~(uintptr_t) (guardpage - 1));
+
+		if (mprotect(page, guardpage, PROT_READ | PROT_WRITE) == 0)
+		{
+			guard.pages[guard.npages++] = page;
+			if (!guard.faulted)
+			{
+				guard.faulted = 1;
+				guard.addr = (unsigned int) (a - guard.mem);
+			}
+			*guard.status = guard.fault;
+			return;
+		}
+	}
+
+	sigaction(SIGSEGV, &guardprev, NULL);
+}
+
+/*
+	Installs guardfault() for the whole process, once.
+*/
+
+static void guardinstall ()
+{
+	struct sigaction sa;
+
+	sa.sa_sigaction = guardfault;
+	sa.sa_flags = SA_SIGINFO;
+	sigemptyset(&sa.sa_mask);
+
+	guardpage = sysconf(_SC_PAGESIZE);
+	guardinstalled = sigaction(SIGSEGV, &sa, &guardprev) == 0;
+}
+
+/*
+	Starts catching faults on the guarded memory at mem for this thread:
+	one sets *status to fault.  status must be volatile since it is
+	changed in the middle of whatever the thread was doing.
+	Returns -1 if the handler can't be installed.
+*/
+
+int guardbegin (unsigned char * mem, volatile int * status, int fault)
+{
+	pthread_once(&guardonce, guardinstall);
+	if (!guardinstalled)
+	{
+		return -1;
+	}
+
+	guard.status = status;
+	guard.fault = fault;
+	guard.faulted = 0;
+	guard.npages = 0;
+	guard.mem = mem;
+	return 0;
+}
+
+/*
+	Stops catching faults and puts the guard back over the pages that
+	faulted, throwing away what was written to them.
+	Returns 1 and the first bad address if there was a fault, or 0.
+*/
+
+int guardend (unsigned int * addr)
+{
+	int i;
+
+	guard.mem = NULL;
+	for (i = 0; i < guard.npages; i++)
+	{
+		mmap(guard.pages[i], guardpage, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+	}
+	guard.npages = 0;
+
+	*addr = guard.addr;
+	return guard.faulted;
+}
+
+/*
+	Resident size in KiB of the guest memory at mem, from /proc/self/smaps.
+	Unlike mincore() this doesn't count pages that have only been read,
+	which all share the kernel's zero page.  The memory can span several
+	mappings when parts of it are mapped from an image.
+	Returns -1 if it can't be found.
+*/
+
+static long smapsresident (const unsigned char * mem, unsigned int size)
+{
+	FILE * smaps = fopen("/proc/self/smaps", "r");
+	char line[256];
+	int inside = 0;
+	long kib = -1;
+	long rss;
+	unsigned long first = (unsigned long) mem;
+	unsigned long last = first + size;
+
+	if (smaps == NULL)
+	{
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), smaps) != NULL)
+	{
+		unsigned long start, end;
+
+		if (sscanf(line, "%lx-%lx ", &start, &end) == 2)
+		{
+			inside = start <= last && end > first;
+		}
+		else if (inside && sscanf(line, "Rss: %ld kB", &rss) == 1)
+		{
+			kib = (kib < 0 ? 0 : kib) + rss;
+		}
+	}
+	fclose(smaps);
+	return kib;
+}
+
+/*
+	Reports how much of the guest memory is resident and the peak resident
+	size of the whole process.
+*/
+
+void printresident (FILE * out, const unsigned char * mem, unsigned int size)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	size_t pages = ((size_t) size + 1 + page - 1) / page;
+	long kib = smapsresident(mem, size);
+	struct rusage usage;
+
+	if (kib < 0)
+	{
+		unsigned char * vec = (unsigned char *) malloc(pages);
+		size_t i, resident = 0;
+
+		if (vec != NULL && mincore((void *) mem, (size_t) size + 1, vec) == 0)
+		{
+			for (i = 0; i < pages; i++)
+			{
+				resident += vec[i] & 1;
+			}
+			kib = resident * page / 1024;
+		}
+		free(vec);
+	}
+
+	fprintf(out, "Guest memory: %ld of %zu KiB resident (.size %u bytes)\n",
+		kib, pages * page / 1024, size);
+
+	getrusage(RUSAGE_SELF, &usage);
+	fprintf(out, "Peak resident set size: %ld KiB\n", usage.ru_maxrss);
+}
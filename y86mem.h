@@ -0,0 +1,68 @@
+// Ryan Bandilla
+// Y86 Guest Memory
+// BKR Comp Arch
+#ifndef Y86MEM_H
+#define Y86MEM_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ *	Guest memory is anonymous mapped memory, so the kernel hands out zero
+ *	pages on first touch and a program declaring a large .size only pays
+ *	for the pages it actually uses.
+ */
+
+/*
+ *	Guarded memory sits at the start of a window covering every 32 bit
+ *	guest address, plus GUARDSLACK for the last bytes of an access there.
+ *	Only the .size bytes (and the spare one) are usable, the rest of the
+ *	window is left inaccessible.  An access outside of memory faults, and
+ *	between guardbegin() and guardend() the fault sets a status instead of
+ *	killing the process.  The faulting page is opened up so the access
+ *	completes harmlessly, the caller sees the status at the end of the
+ *	instruction and stops.  guardend() closes the pages again and reports
+ *	the first bad address.
+ */
+
+#define GUARDWINDOW (1ULL << 32)
+#define GUARDSLACK 4
+
+/*
+ *	Guest words are 32 bit little endian at any alignment.  memcpy lets
+ *	the compiler use one unaligned move where the host allows it, and the
+ *	bytes are swapped on a big endian host.
+ */
+
+static inline int load32 (const unsigned char * p)
+{
+	unsigned int v;
+
+	memcpy(&v, p, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = __builtin_bswap32(v);
+#endif
+	return (int) v;
+}
+
+static inline void store32 (unsigned char * p, int value)
+{
+	unsigned int v = (unsigned int) value;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = __builtin_bswap32(v);
+#endif
+	memcpy(p, &v, 4);
+}
+
+unsigned char * memalloc (size_t size, int noreserve);
+void memfree (unsigned char * mem, size_t size);
+int memclear (unsigned char * mem, size_t size, int noreserve);
+unsigned char * memguard (size_t size, int noreserve);
+void memunguard (unsigned char * mem, size_t size);
+int guardbegin (unsigned char * mem, volatile int * status, int fault);
+int guardend (unsigned int * addr);
+void printresident (FILE * out, const unsigned char * mem, unsigned int size);
+
+#endif
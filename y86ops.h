@@ -0,0 +1,665 @@
+// Ryan Bandilla
+// Y86 Instruction Handlers
+// BKR Comp Arch
+
+/*
+ *	The body of every handler, shared by the dispatch engines in run()
+ *	(y86vm.c) so they can't drift apart.  Not a normal header: it is
+ *	included inside the engine loop after defining
+ *
+ *	OP(h)  - Start of the handler for h
+ *	NEXT   - Finish the instruction and dispatch the next one
+ *
+ *	and runs on run()'s locals: pc, reg, OF, ZF, SF, status, d, arg1,
+ *	arg2, the run's GuestIO io (see y86io.h), the VM's out stream for
+ *	errors and the scratch variables.  The flags are lazy, see LAZYZS(),
+ *	LAZYOF() and FLAGS() in y86vm.c.
+ *
+ *	CHECKPOINT() follows every taken jump, call and return, so a program
+ *	can't run on without passing one, see CHECKPOINT() in y86vm.c.
+ *	PROBEREAD() and PROBEWRITE() come before every load and store of
+ *	guest memory, PROBECALL() and PROBERET() with every call and return,
+ *	PROBEBRANCH() with the outcome and target of every conditional jump.
+ *	They are empty except in the probed engine (y86probe.h).
+ *
+ *	Guest addresses are taken as unsigned 32 bit numbers into addr, a
+ *	size_t, so memspace[addr + 3] stays inside the 4 GiB window of guarded
+ *	memory and OUTSIDE() (y86vm.c) can't wrap.  Every load and store
+ *	checks its address with OUTSIDE() first and stops with ADR instead of
+ *	making the access.  With GUARDED defined those checks are left out,
+ *	the guard pages catch every access instead (see y86mem.h).  Only the
+ *	part of an access past the end faults, so there a store checks with
+ *	CROSSES() that it doesn't start inside and run off the end, and a
+ *	load checks FAULTED() before it keeps what it read.  Either way the
+ *	run stops with memory and registers as the checked engines leave
+ *	them.
+ */
+
+	// First time at this address, decode it and go round again
+	OP(H_DECODE)
+
+		count--;
+
+		if (dcachefill(dc, memspace, pc) == NULL)
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: Instruction runs past the end of memory. Memory Location: %x\n", pc);
+		}
+
+	NEXT;
+
+	// 00 NOP
+	OP(H_NOP)
+		
+		pc++;	// NOP so program conitnues
+		
+	NEXT;
+
+	// 10 HALT
+	OP(H_HALT)
+		
+		status = HLT;	// Assumed this occurs at the end of program
+		
+	NEXT;
+
+	// 20 RRMOVL srcR desR
+	OP(H_RRMOVL)
+		
+		reg[arg2] = reg[arg1];					//	Puts info from source into destination
+		
+		pc += 2;
+
+	NEXT;
+
+	// 30 IRMOVL notR desR value
+	OP(H_IRMOVL)
+		
+		if (arg1 < 0x08)
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: IRMOVL instruction has two addresses. Memory Location: %x\n", pc);
+			NEXT;
+		}
+		
+		reg[arg2] = d->imm;						// Storing final value in destination register
+		
+		pc += 6;
+
+	NEXT;
+
+	// 40 RMMOVL srcR desR value = (32bit displacement off desR)
+	OP(H_RMMOVL)
+		
+		value = d->imm;							// This is the offset amount
+
+		addr = (unsigned int) (value + reg[arg2]);
+
+#ifdef GUARDED
+		if (CROSSES(addr, 4))
+#else
+		if (OUTSIDE(addr, 4))
+#endif
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: RMMOVL instruction address offset larger than memory space. Memory Location: %x\n", pc);
+			NEXT;
+		}
+
+		PROBEWRITE(addr, 4);
+		dcachewrite(dc, addr, 4);
+
+		store32(memspace + addr, reg[arg1]);	// Stores the integer at the specified location
+
+		pc += 6;
+
+	NEXT;
+
+	// 50 MRMOVL desR srcR value = (32bit displacement off srcR)
+	OP(H_MRMOVL)
+
+		value = d->imm;							// This is the offset amount
+
+		addr = (unsigned int) (value + reg[arg2]);
+
+#ifndef GUARDED
+		if (OUTSIDE(addr, 4))
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: MRMOVL instruction address offset larger than memory space. Memory Location: %x\n", pc);
+			NEXT;
+		}
+#endif
+
+		PROBEREAD(addr, 4);
+		value = load32(memspace + addr);		// Loads the integer at the specified address
+#ifdef GUARDED
+		if (FAULTED())
+		{
+			NEXT;
+		}
+#endif
+
+		reg[arg1] = value;
+
+		pc += 6;
+
+	NEXT;
+
+	// 60 ADDL srcR desR 
+	OP(H_ADDL)
+
+		num1 = reg[arg1];
+		num2 = reg[arg2];
+		
+		value = num1 + num2;
+
+		// Flags are worked out from these when something reads them
+		LAZYZS(value);
+		LAZYOF(OF_ADD, num1, num2, value);
+
+		reg[arg2] = value;
+
+		pc += 2;
+
+	NEXT;
+
+	// 61 SUBL srcR desR
+	OP(H_SUBL)
+
+		num1 = reg[arg1];
+		num2 = reg[arg2];
+		
+		value = num2 - num1;
+
+		// Flags are worked out from these when something reads them
+		LAZYZS(value);
+		LAZYOF(OF_SUB, num1, num2, value);
+
+		reg[arg2] = value;
+
+		pc += 2;
+
+	NEXT;
+
+	// 62 ANDL srcR desR
+	OP(H_ANDL)
+
+		num1 = reg[arg1];
+		num2 = reg[arg2];
+		
+		value = num1 & num2;
+
+		// Flags are worked out from this when something reads them, OF
+		// is left alone
+		LAZYZS(value);
+
+		reg[arg2] = value;
+
+		pc += 2;
+
+	NEXT;
+
+	// 63 XORL srcR desR
+	OP(H_XORL)
+
+		num1 = reg[arg1];
+		num2 = reg[arg2];
+		
+		value = num1 ^ num2;
+
+		// Flags are worked out from this when something reads them, OF
+		// is left alone
+		LAZYZS(value);
+
+		reg[arg2] = value;
+
+		pc += 2;
+
+	NEXT;
+
+	// 64 MULL srcR desR
+	OP(H_MULL)
+
+		num1 = reg[arg1];
+		num2 = reg[arg2];
+		
+		value = num1 * num2;
+
+		// Flags are worked out from these when something reads them
+		LAZYZS(value);
+		LAZYOF(OF_MUL, num1, num2, value);
+
+		reg[arg2] = value;
+
+		pc += 2;
+
+	NEXT;
+
+	// 65 CMPL
+	OP(H_CMPL)
+
+		num1 = reg[arg1];
+		num2 = reg[arg2];
+		
+		value = num2 - num1;
+
+		// Flags are worked out from these when something reads them
+		LAZYZS(value);
+		LAZYOF(OF_SUB, num1, num2, value);
+
+		pc += 2;
+
+	NEXT;
+	
+	// 70 JMP 32bit destination
+	OP(H_JMP)
+		// Unconditional Jump
+		pc = d->imm;
+		CHECKPOINT();
+
+	NEXT;
+
+	// 71 JLE 32bit destination
+	OP(H_JLE)
+		// Jump if less than or equal to
+		FLAGS();
+		if (ZF == 1 || (SF ^ OF))
+		{
+			PROBEBRANCH(pc, 1, d->imm);
+			pc = d->imm;
+			CHECKPOINT();
+		}
+		else
+		{
+			PROBEBRANCH(pc, 0, d->imm);
+			pc += 5;
+		}
+
+	NEXT;
+
+	// 72 JL  32bit destination
+	OP(H_JL)
+		// Jump if strictly less than
+		FLAGS();
+		if (ZF == 0 && (SF ^ OF))
+		{
+			PROBEBRANCH(pc, 1, d->imm);
+			pc = d->imm;
+			CHECKPOINT();
+		}
+		else
+		{
+			PROBEBRANCH(pc, 0, d->imm);
+			pc += 5;
+		}
+
+	NEXT;
+
+	// 73 JE  32bit destination
+	OP(H_JE)
+		// Jump if equal
+		FLAGS();
+		if (ZF == 1)
+		{
+			PROBEBRANCH(pc, 1, d->imm);
+			pc = d->imm;
+			CHECKPOINT();
+		}
+		else
+		{
+			PROBEBRANCH(pc, 0, d->imm);
+			pc += 5;
+		}
+
+	NEXT;
+
+	// 74 JNE 32bit destination
+	OP(H_JNE)
+		// Jump if not equal
+		FLAGS();
+		if (ZF == 0)
+		{
+			PROBEBRANCH(pc, 1, d->imm);
+			pc = d->imm;
+			CHECKPOINT();
+		}
+		else
+		{
+			PROBEBRANCH(pc, 0, d->imm);
+			pc += 5;
+		}
+		
+	NEXT;
+
+	// 75 JGE 32bit destination
+	OP(H_JGE)
+		// Jump if greater than or equal to
+		FLAGS();
+		if (!(ZF == 0 && (SF ^ OF)))
+		{
+			PROBEBRANCH(pc, 1, d->imm);
+			pc = d->imm;
+			CHECKPOINT();
+		}
+		else
+		{
+			PROBEBRANCH(pc, 0, d->imm);
+			pc += 5;
+		}
+
+	NEXT;
+
+	// 76 JG  32bit destination
+	OP(H_JG)
+		// Jump if strictly greater than
+		FLAGS();
+		if (!(ZF == 1 || (SF ^ OF)))
+		{
+			PROBEBRANCH(pc, 1, d->imm);
+			pc = d->imm;
+			CHECKPOINT();
+		}
+		else
+		{
+			PROBEBRANCH(pc, 0, d->imm);
+			pc += 5;
+		}
+
+	NEXT;
+
+	// 80 CALL 32bit destination
+	OP(H_CALL)
+
+		value = d->imm;							// Destination, read before the push
+		
+		reg[4] -= 4;							// %ESP
+
+		addr = (unsigned int) reg[4];
+
+#ifdef GUARDED
+		if (CROSSES(addr, 4))
+#else
+		if (OUTSIDE(addr, 4))
+#endif
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: CALL instruction address outside of memory space. Memory Location: %x\n", pc);
+			NEXT;
+		}
+
+		PROBEWRITE(addr, 4);
+		dcachewrite(dc, addr, 4);
+
+		store32(memspace + addr, pc + 5);		// Pushes the return address
+
+		PROBECALL(pc + 5, value);
+		pc = value;
+		CHECKPOINT();
+
+	NEXT;
+
+	// 90 RET 32bit destination
+	OP(H_RET)
+
+		addr = (unsigned int) reg[4];
+
+#ifndef GUARDED
+		if (OUTSIDE(addr, 4))
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: RET instruction address outside of memory space. Memory Location: %x\n", pc);
+			NEXT;
+		}
+#endif
+	
+		PROBEREAD(addr, 4);
+		value = load32(memspace + addr);		// Pops the return address
+#ifdef GUARDED
+		if (FAULTED())
+		{
+			NEXT;
+		}
+#endif
+
+		PROBERET(pc, value);
+		pc = value;
+		reg[4] += 4;
+		CHECKPOINT();
+
+	NEXT;
+
+	// A0 PUSHL 
+	OP(H_PUSHL)
+
+		reg[4] -= 4;
+
+		addr = (unsigned int) reg[4];
+
+#ifdef GUARDED
+		if (CROSSES(addr, 4))
+#else
+		if (OUTSIDE(addr, 4))
+#endif
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: PUSHL instruction address outside of memory space. Memory Location: %x\n", pc);
+			NEXT;
+		}
+
+		PROBEWRITE(addr, 4);
+		dcachewrite(dc, addr, 4);
+		
+		store32(memspace + addr, reg[arg1]);	// %ESP itself is pushed already decremented
+
+		pc += 2;
+
+	NEXT;
+
+	// B0 POPL
+	OP(H_POPL)
+
+		addr = (unsigned int) reg[4];
+
+#ifndef GUARDED
+		if (OUTSIDE(addr, 4))
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: POPL instruction address outside of memory space. Memory Location: %x\n", pc);
+			NEXT;
+		}
+#endif
+
+		PROBEREAD(addr, 4);
+		value = load32(memspace + addr);
+#ifdef GUARDED
+		if (FAULTED())
+		{
+			NEXT;
+		}
+#endif
+
+		reg[arg1] = value;
+		reg[4] += 4;
+		pc += 2;
+
+	NEXT;
+
+	// C0 READB 
+	OP(H_READB)
+
+		FLAGS();		// SF and OF are kept
+		ZF = 0;
+		
+		value = d->imm;
+
+		if (1 > iogetc(&io, &inputchar))
+		{
+			ZF = 1;
+		}
+
+		addr = (unsigned int) (reg[arg1] + value);
+
+#ifndef GUARDED
+		if (OUTSIDE(addr, 1))
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: READB instruction address outside of memory space. Memory Location: %x\n", pc);
+			NEXT;
+		}
+#endif
+
+		PROBEWRITE(addr, 1);
+		dcachewrite(dc, addr, 1);
+		
+		memspace[addr] = inputchar;
+
+		pc += 6;
+
+	NEXT;
+
+	// C1 READL
+	OP(H_READL)
+
+		FLAGS();		// SF and OF are kept
+		ZF = 0;
+		
+		// Store the results of the read to ensure we exit at the right time
+		value = d->imm;
+		badscan = iogetint(&io, &inputword);
+		if (badscan < 1)
+		{
+			ZF = 1;
+		}
+		
+		addr = (unsigned int) (reg[arg1] + value);
+
+#ifdef GUARDED
+		if (CROSSES(addr, 4))
+#else
+		if (OUTSIDE(addr, 4))
+#endif
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: READL instruction address outside of memory space. Memory Location: %x\n", pc);
+			NEXT;
+		}
+
+		PROBEWRITE(addr, 4);
+		dcachewrite(dc, addr, 4);
+
+		store32(memspace + addr, inputword);	// Stores the integer at the specified location
+
+		pc += 6;
+
+	NEXT;
+
+	// D0 WRTIEB
+	OP(H_WRITEB)
+
+		value = d->imm;
+		addr = (unsigned int) (reg[arg1] + value);
+
+#ifndef GUARDED
+		if (OUTSIDE(addr, 1))
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: WRITEB instruction address outside of memory space. Memory Location: %x\n", pc);
+			NEXT;
+		}
+#endif
+
+		PROBEREAD(addr, 1);
+		num1 = memspace[addr];
+#ifdef GUARDED
+		if (FAULTED())
+		{
+			NEXT;
+		}
+#endif
+
+		ioputc(&io, (char)num1);
+		pc += 6;
+
+	NEXT;
+
+	// D1 WRITEL
+	OP(H_WRITEL)
+
+		value = d->imm;
+		addr = (unsigned int) (value + reg[arg1]);
+
+#ifndef GUARDED
+		if (OUTSIDE(addr, 4))
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: WRITEL instruction address outside of memory space. Memory Location: %x\n", pc);
+			NEXT;
+		}
+#endif
+
+		PROBEREAD(addr, 4);
+		num1 = load32(memspace + addr);
+#ifdef GUARDED
+		if (FAULTED())
+		{
+			NEXT;
+		}
+#endif
+
+		ioputint(&io, num1);
+		pc += 6;
+
+	NEXT;
+
+	// E0 MOVSBL
+	OP(H_MOVSBL)
+
+		value = d->imm;
+
+		// Only the byte at value + 3 is loaded, over the sign of the top
+		// byte of srcR.  That byte is left in inputchar, where a READB at
+		// the end of input picks it up.
+		inputchar = (char) (reg[arg2] >> 24);
+
+		addr = (unsigned int) (reg[arg2] + value);
+
+#ifndef GUARDED
+		if (OUTSIDE(addr + 3, 1))
+		{
+			status = ADR;
+			ioflush(&io);
+			fprintf(out, "ERROR: MOVSBL instruction address outside of memory space. Memory Location: %x\n", pc);
+			NEXT;
+		}
+#endif
+
+		PROBEREAD(addr + 3, 1);
+		num1 = memspace[addr + 3];
+#ifdef GUARDED
+		if (FAULTED())
+		{
+			NEXT;
+		}
+#endif
+
+		reg[arg1] = num1 | ((inputchar >> 7 & 1) ? 0xffffff00 : 0);
+		pc += 6;
+
+	NEXT;
+
+	// Invalid instruction encountered
+	OP(H_INVALID)
+		status = INS;
+	NEXT;
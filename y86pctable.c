@@ -0,0 +1,102 @@
+// Ryan Bandilla
+// Y86 Per PC Counters
+// BKR Comp Arch
+#include <string.h>
+#include <stdlib.h>
+#include "y86pctable.h"
+
+/*
+	An empty table of width counters per pc.  Returns 0, or -1 if
+	there's no memory for it.
+*/
+
+int pctableinit (PcTable * t, unsigned int width)
+{
+	t->width = width;
+	t->nslots = PCTABLESLOTS;
+	t->npcs = 0;
+	t->failed = 0;
+	t->slots = (long long *) calloc((size_t) t->nslots * (width + 1), sizeof(long long));
+	return t->slots != NULL ? 0 : -1;
+}
+
+/*
+	Releases the slots of a table.
+*/
+
+void pctablefree (PcTable * t)
+{
+	free(t->slots);
+	t->slots = NULL;
+}
+
+/*
+	Adds pc, which isn't in the table, doubling the table first if it is
+	half full.  Returns its counters, or NULL if the table can't grow.
+*/
+
+long long * pcadd (PcTable * t, unsigned int pc)
+{
+	size_t stride = t->width + 1;
+	long long * grown;
+	long long * s;
+	unsigned int i;
+
+	if (t->npcs + 1 > t->nslots / 2)
+	{
+		grown = (long long *) calloc((size_t) t->nslots * 2 * stride, sizeof(long long));
+		if (grown == NULL)
+		{
+			t->failed = 1;
+			return NULL;
+		}
+		for (i = 0; i < t->nslots; i++)
+		{
+			s = &t->slots[i * stride];
+			if (s[0] != 0)
+			{
+				memcpy(pcslot(grown, t->nslots * 2, t->width, (unsigned int) (s[0] - 1)), s,
+					stride * sizeof(long long));
+			}
+		}
+		free(t->slots);
+		t->slots = grown;
+		t->nslots *= 2;
+	}
+
+	s = pcslot(t->slots, t->nslots, t->width, pc);
+	s[0] = (long long) pc + 1;
+	t->npcs++;
+	return s + 1;
+}
+
+/*
+	The counters of pc, or NULL if it isn't in the table.
+*/
+
+const long long * pcfind (const PcTable * t, unsigned int pc)
+{
+	const long long * s = pcslot(t->slots, t->nslots, t->width, pc);
+
+	return s[0] != 0 ? s + 1 : NULL;
+}
+
+/*
+	Writes every pc in the table to pcs, which has room for npcs of
+	them, and returns how many there are.
+*/
+
+unsigned int pctablepcs (const PcTable * t, unsigned int * pcs)
+{
+	size_t stride = t->width + 1;
+	unsigned int i, n = 0;
+
+	for (i = 0; i < t->nslots; i++)
+	{
+		if (t->slots[i * stride] != 0)
+		{
+			pcs[n++] = (unsigned int) (t->slots[i * stride] - 1);
+		}
+	}
+	return n;
+}
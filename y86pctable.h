@@ -0,0 +1,63 @@
+// Ryan Bandilla
+// Y86 Per PC Counters
+// BKR Comp Arch
+#ifndef Y86PCTABLE_H
+#define Y86PCTABLE_H
+
+/*
+ *	Counters of each pc a run reaches, for the reports of the probes
+ *	(y86probe.h).  Only the pcs that are counted take room, so a program
+ *	with a large .size costs no more than a small one running the same
+ *	code.  Each pc has width counters, all 0 when it is added, in a
+ *	table hashed on the pc that doubles when it gets half full.
+ *
+ *	pccounters() - The counters of pc, added if it isn't there.  NULL
+ *	               if the table can't grow, then failed is set and
+ *	               the pc goes uncounted.  pcadd() is the part of it
+ *	               for a pc that isn't there yet
+ *	pcfind()     - The counters of pc, or NULL if it was never added
+ *	pctablepcs() - Every pc added, in no order
+ *
+ *	A pointer from pccounters() is good until the next pc is added.
+ */
+
+#define PCTABLESLOTS 1024		//	Slots to start with
+
+typedef struct
+{
+	long long * slots;			//	pc + 1, 0 if empty, then its counters
+	unsigned int width;			//	Counters of each pc
+	unsigned int nslots;		//	A power of two
+	unsigned int npcs;			//	Slots used
+	int failed;					//	Out of memory, some pcs weren't added
+} PcTable;
+
+int pctableinit (PcTable * t, unsigned int width);
+void pctablefree (PcTable * t);
+long long * pcadd (PcTable * t, unsigned int pc);
+const long long * pcfind (const PcTable * t, unsigned int pc);
+unsigned int pctablepcs (const PcTable * t, unsigned int * pcs);
+
+/*
+ *	The slot pc is in, or the empty one it would go in.
+ */
+
+static inline long long * pcslot (long long * slots, unsigned int nslots, unsigned int width, unsigned int pc)
+{
+	unsigned int i = (pc * 2654435761u) & (nslots - 1);
+
+	while (slots[(size_t) i * (width + 1)] != 0 && slots[(size_t) i * (width + 1)] != (long long) pc + 1)
+	{
+		i = (i + 1) & (nslots - 1);
+	}
+	return &slots[(size_t) i * (width + 1)];
+}
+
+static inline long long * pccounters (PcTable * t, unsigned int pc)
+{
+	long long * s = pcslot(t->slots, t->nslots, t->width, pc);
+
+	return s[0] != 0 ? s + 1 : pcadd(t, pc);
+}
+
+#endif
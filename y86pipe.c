@@ -0,0 +1,299 @@
+// Ryan Bandilla
+// Y86 Pipeline Model
+// BKR Comp Arch
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "y86pipe.h"
+#include "y86disasm.h"
+
+#define NOREG -1
+#define ESP 4
+
+static const char * causename[PIPE_CAUSES] = { "load/use", "mispredict", "ret" };
+
+/*
+	A model of a run of a program with memsize bytes at mem.  Returns
+	NULL if there's no memory for it.
+*/
+
+Pipeline * pipecreate (const unsigned char * mem, unsigned int memsize)
+{
+	Pipeline * pl = (Pipeline *) calloc(1, sizeof(Pipeline));
+	int i;
+
+	if (pl == NULL)
+	{
+		return NULL;
+	}
+	if (pctableinit(&pl->stalls, 1) != 0)
+	{
+		free(pl);
+		return NULL;
+	}
+	pl->mem = mem;
+	pl->memsize = memsize;
+	for (i = 0; i < PIPEHISTORY; i++)
+	{
+		pl->history[i].dste = NOREG;
+		pl->history[i].dstm = NOREG;
+	}
+	return pl;
+}
+
+/*
+	Releases a model.
+*/
+
+void pipefree (Pipeline * pl)
+{
+	if (pl != NULL)
+	{
+		pctablefree(&pl->stalls);
+		free(pl);
+	}
+}
+
+/*
+	Moves the instructions ahead one stage, dste and dstm entering
+	execute behind them.
+*/
+
+static void advance (Pipeline * pl, int dste, int dstm)
+{
+	memmove(&pl->history[1], &pl->history[0], (PIPEHISTORY - 1) * sizeof(PipeSlot));
+	pl->history[0].dste = (signed char) dste;
+	pl->history[0].dstm = (signed char) dstm;
+}
+
+/*
+	Counts where a source register comes from: forwarded from the stage
+	of the nearest instruction ahead writing it, or the register file if
+	none is.
+*/
+
+static void forward (Pipeline * pl, int src)
+{
+	int i;
+
+	if (src == NOREG)
+	{
+		return;
+	}
+	for (i = 0; i < PIPEHISTORY; i++)
+	{
+		if (pl->history[i].dstm == src || pl->history[i].dste == src)
+		{
+			pl->forwards[i]++;
+			return;
+		}
+	}
+}
+
+/*
+	Charges n bubble cycles of cause to the instruction at pc.
+*/
+
+static void stall (Pipeline * pl, unsigned int pc, PipeStall cause, int n)
+{
+	long long * cycles;
+
+	pl->events[cause]++;
+	pl->bubbles[cause] += n;
+	if (pc < pl->memsize && (cycles = pccounters(&pl->stalls, pc)) != NULL)
+	{
+		*cycles += n;
+	}
+}
+
+/*
+	The instruction at pc, whose first byte is op, entering decode.
+*/
+
+void pipeinsn (Pipeline * pl, unsigned int pc, unsigned char op)
+{
+	int ra = NOREG, rb = NOREG;
+	int srca = NOREG, srcb = NOREG, dste = NOREG, dstm = NOREG;
+
+	if (pc + 1 < pl->memsize)
+	{
+		ra = pl->mem[pc + 1] >> 4;
+		rb = pl->mem[pc + 1] & 0x0f;
+		ra = ra < 8 ? ra : NOREG;
+		rb = rb < 8 ? rb : NOREG;
+	}
+
+	// Registers read in decode and written back from execute and memory,
+	// as PIPE's srcA, srcB, dstE and dstM
+	switch (op)
+	{
+		case 0x20:			// rrmovl
+			srca = ra;
+			dste = rb;
+			break;
+		case 0x30:			// irmovl
+			dste = rb;
+			break;
+		case 0x40:			// rmmovl
+			srca = ra;
+			srcb = rb;
+			break;
+		case 0x50:			// mrmovl
+		case 0xE0:			// movsbl
+			srcb = rb;
+			dstm = ra;
+			break;
+		case 0x60: case 0x61: case 0x62: case 0x63: case 0x64: case 0x65:
+			srca = ra;
+			srcb = rb;
+			dste = op != 0x65 ? rb : NOREG;
+			break;
+		case 0x80:			// call
+			srcb = ESP;
+			dste = ESP;
+			break;
+		case 0x90:			// ret
+			srca = ESP;
+			srcb = ESP;
+			dste = ESP;
+			break;
+		case 0xA0:			// pushl
+			srca = ra;
+			srcb = ESP;
+			dste = ESP;
+			break;
+		case 0xB0:			// popl
+			srca = ESP;
+			srcb = ESP;
+			dste = ESP;
+			dstm = ra;
+			break;
+		case 0xC0: case 0xC1: case 0xD0: case 0xD1:
+			srcb = ra;
+			break;
+	}
+
+	// Bubbles of the branch or return before this one
+	for (; pl->pending > 0; pl->pending--)
+	{
+		advance(pl, NOREG, NOREG);
+	}
+
+	// A load right ahead only has its value at the end of memory, so this
+	// one waits a cycle in decode and takes it from there
+	if (pl->history[0].dstm != NOREG &&
+		(srca == pl->history[0].dstm || srcb == pl->history[0].dstm))
+	{
+		stall(pl, pc, PIPE_LOADUSE, 1);
+		advance(pl, NOREG, NOREG);
+	}
+
+	forward(pl, srca);
+	forward(pl, srcb);
+	advance(pl, dste, dstm);
+	pl->instructions++;
+
+	if (op == 0x90)
+	{
+		stall(pl, pc, PIPE_RET, 3);
+		pl->pending = 3;
+	}
+}
+
+/*
+	The outcome of the conditional jump at pc.  PIPE predicts every jump
+	taken, so one that isn't cancels the two instructions fetched from
+	its target.
+*/
+
+void pipebranch (Pipeline * pl, unsigned int pc, int taken)
+{
+	if (!taken)
+	{
+		stall(pl, pc, PIPE_MISPREDICT, 2);
+		pl->pending = 2;
+	}
+}
+
+typedef struct
+{
+	unsigned int pc;
+	long long cycles;
+} StallPc;
+
+static int morestalls (const void * a, const void * b)
+{
+	const StallPc * x = (const StallPc *) a;
+	const StallPc * y = (const StallPc *) b;
+
+	if (x->cycles != y->cycles)
+	{
+		return x->cycles < y->cycles ? 1 : -1;
+	}
+	return x->pc < y->pc ? -1 : x->pc > y->pc;
+}
+
+/*
+	Prints the cycles and CPI of the run, the bubbles of each cause, the
+	operands forwarded and the top pcs losing the most cycles.
+*/
+
+void pipereport (FILE * out, const Pipeline * pl, int top)
+{
+	size_t room = pl->stalls.npcs > 0 ? pl->stalls.npcs : 1;
+	StallPc * pcs = (StallPc *) malloc(room * sizeof(StallPc));
+	unsigned int * at = (unsigned int *) malloc(room * sizeof(unsigned int));
+	long long bubbles = 0, cycles;
+	unsigned int k, n;
+	char text[64];
+	int i;
+
+	for (i = 0; i < PIPE_CAUSES; i++)
+	{
+		bubbles += pl->bubbles[i];
+	}
+	cycles = pl->instructions > 0 ? pl->instructions + 4 + bubbles : 0;
+
+	fprintf(out, "Pipeline of %lld instructions in %lld cycles, CPI %.3f\n",
+		pl->instructions, cycles, pl->instructions > 0 ? (double) cycles / pl->instructions : 0);
+	fprintf(out, "\tstall             events        cycles  of cycles\n");
+	for (i = 0; i < PIPE_CAUSES; i++)
+	{
+		fprintf(out, "\t%-10s  %12lld  %12lld    %6.2f%%\n", causename[i], pl->events[i],
+			pl->bubbles[i], cycles > 0 ? 100.0 * pl->bubbles[i] / cycles : 0);
+	}
+	fprintf(out, "\tforwarded from execute %lld, memory %lld, writeback %lld\n",
+		pl->forwards[0], pl->forwards[1], pl->forwards[2]);
+
+	if (pcs == NULL || at == NULL)
+	{
+		free(pcs);
+		free(at);
+		return;
+	}
+	n = pctablepcs(&pl->stalls, at);
+	for (k = 0; k < n; k++)
+	{
+		pcs[k].pc = at[k];
+		pcs[k].cycles = *pcfind(&pl->stalls, at[k]);
+	}
+	qsort(pcs, n, sizeof(StallPc), morestalls);
+
+	fprintf(out, "\nStalls by pc:\n");
+	if (pl->stalls.failed)
+	{
+		fprintf(out, "\t(out of memory, some pcs are missing)\n");
+	}
+	fprintf(out, "\t        cycles       %%\n");
+	for (i = 0; i < (int) n && i < top; i++)
+	{
+		if (disasm(pl->mem, pl->memsize, pcs[i].pc, text, sizeof(text)) == 0)
+		{
+			strcpy(text, "(invalid)");
+		}
+		fprintf(out, "\t%14lld  %5.1f%%  [0x%08x]\t%s\n", pcs[i].cycles,
+			bubbles > 0 ? 100.0 * pcs[i].cycles / bubbles : 0, pcs[i].pc, text);
+	}
+	free(pcs);
+	free(at);
+}
@@ -0,0 +1,65 @@
+// Ryan Bandilla
+// Y86 Pipeline Model
+// BKR Comp Arch
+#ifndef Y86PIPE_H
+#define Y86PIPE_H
+
+#include <stdio.h>
+#include "y86pctable.h"
+
+/*
+ *	Cycle counts of the run on PIPE, the five stage pipeline of fetch,
+ *	decode, execute, memory and writeback, fed by the probes (see
+ *	y86probe.h).  The program still runs one instruction at a time; the
+ *	model follows the instructions as they retire and charges the cycles
+ *	PIPE would lose:
+ *
+ *	PIPE_LOADUSE    - 1 bubble when an instruction reads the register
+ *	                  the load (MRMOVL, POPL, MOVSBL) right before it
+ *	                  loads
+ *	PIPE_MISPREDICT - 2 bubbles for a conditional jump not taken, PIPE
+ *	                  fetches from the target first
+ *	PIPE_RET        - 3 bubbles after every RET while the return address
+ *	                  is loaded
+ *
+ *	Every other dependency is met by forwarding from the execute, memory
+ *	or writeback stage, which is counted too.  The first instruction
+ *	takes 5 cycles to come through and every later one 1, plus bubbles.
+ */
+
+typedef enum
+{
+	PIPE_LOADUSE,
+	PIPE_MISPREDICT,
+	PIPE_RET,
+	PIPE_CAUSES
+} PipeStall;
+
+#define PIPEHISTORY 3			//	Stages an operand can be forwarded from
+
+typedef struct
+{
+	signed char dste;			//	Register written from execute, -1 for none
+	signed char dstm;			//	Register written from memory, -1 for none
+} PipeSlot;
+
+typedef struct
+{
+	const unsigned char * mem;	//	Program memory, to decode registers
+	unsigned int memsize;
+	long long instructions;
+	long long bubbles[PIPE_CAUSES];
+	long long events[PIPE_CAUSES];		//	Stalls, mispredictions and returns
+	long long forwards[PIPEHISTORY];	//	Operands from execute, memory, writeback
+	PipeSlot history[PIPEHISTORY];		//	Instructions ahead of the next one
+	int pending;				//	Bubbles still to come before the next one
+	PcTable stalls;				//	Bubble cycles charged to each pc
+} Pipeline;
+
+Pipeline * pipecreate (const unsigned char * mem, unsigned int memsize);
+void pipefree (Pipeline * pl);
+void pipeinsn (Pipeline * pl, unsigned int pc, unsigned char op);
+void pipebranch (Pipeline * pl, unsigned int pc, int taken);
+void pipereport (FILE * out, const Pipeline * pl, int top);
+
+#endif
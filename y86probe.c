@@ -0,0 +1,33 @@
+// Ryan Bandilla
+// Y86 Probes
+// BKR Comp Arch
+#include <stdio.h>
+#include "y86probe.h"
+
+/*
+	Whether any model is set, so a run needs the probed engine.
+*/
+
+int probesactive (const Probes * p)
+{
+	return p->profile != NULL || p->calls != NULL || p->cache != NULL ||
+		p->pipe != NULL || p->branch != NULL;
+}
+
+/*
+	Releases every model and leaves the probes empty.
+*/
+
+void probesfree (Probes * p)
+{
+	proffree(p->profile);
+	callfree(p->calls);
+	cachefree(p->cache);
+	pipefree(p->pipe);
+	branchfree(p->branch);
+	p->profile = NULL;
+	p->calls = NULL;
+	p->cache = NULL;
+	p->pipe = NULL;
+	p->branch = NULL;
+}
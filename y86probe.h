@@ -0,0 +1,108 @@
+// Ryan Bandilla
+// Y86 Probes
+// BKR Comp Arch
+#ifndef Y86PROBE_H
+#define Y86PROBE_H
+
+#include <stddef.h>
+#include "y86prof.h"
+#include "y86calls.h"
+#include "y86cache.h"
+#include "y86pipe.h"
+#include "y86branch.h"
+
+/*
+ *	Models watching a run from inside the interpreter.  A VM with probes
+ *	runs on an instance of the switch engine built with the probe calls
+ *	in it (see run() in y86vm.c), the other engines are built without
+ *	them and pay nothing.  Each model is left out while its pointer is
+ *	NULL.
+ *
+ *	probeinsn()   - Before each instruction, with its first byte
+ *	probeaccess() - Each load (write 0) or store (write 1) of n bytes
+ *	probecall()   - A CALL of func, returning to ret
+ *	proberet()    - The RET at pc, to the address to
+ *	probebranch() - A conditional jump at pc to target, taken or not
+ */
+
+typedef struct
+{
+	Profile * profile;			//	y86prof.h
+	CallGraph * calls;			//	y86calls.h
+	CacheSim * cache;			//	y86cache.h
+	Pipeline * pipe;			//	y86pipe.h
+	BranchSim * branch;			//	y86branch.h
+} Probes;
+
+int probesactive (const Probes * p);
+void probesfree (Probes * p);
+
+static inline void probeinsn (Probes * p, unsigned int pc, unsigned char op)
+{
+	if (p->profile != NULL)
+	{
+		profinsn(p->profile, pc, op);
+	}
+	if (p->calls != NULL)
+	{
+		callinsn(p->calls);
+	}
+	if (p->cache != NULL)
+	{
+		cachefetch(p->cache, pc, op);
+	}
+	if (p->pipe != NULL)
+	{
+		pipeinsn(p->pipe, pc, op);
+	}
+}
+
+static inline void probeaccess (Probes * p, size_t addr, int n, int write)
+{
+	if (p->profile != NULL)
+	{
+		profaccess(p->profile, addr, write);
+	}
+	if (p->cache != NULL)
+	{
+		cachedata(p->cache, addr, n, write);
+	}
+}
+
+static inline void probecall (Probes * p, unsigned int ret, unsigned int func)
+{
+	if (p->calls != NULL)
+	{
+		callenter(p->calls, ret, func);
+	}
+	if (p->branch != NULL)
+	{
+		branchcall(p->branch, ret);
+	}
+}
+
+static inline void proberet (Probes * p, unsigned int pc, unsigned int to)
+{
+	if (p->calls != NULL)
+	{
+		callreturn(p->calls, to);
+	}
+	if (p->branch != NULL)
+	{
+		branchret(p->branch, pc, to);
+	}
+}
+
+static inline void probebranch (Probes * p, unsigned int pc, int taken, unsigned int target)
+{
+	if (p->pipe != NULL)
+	{
+		pipebranch(p->pipe, pc, taken);
+	}
+	if (p->branch != NULL)
+	{
+		branchcond(p->branch, pc, taken, target);
+	}
+}
+
+#endif
@@ -0,0 +1,178 @@
+// Ryan Bandilla
+// Y86 Profiler
+// BKR Comp Arch
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "y86prof.h"
+#include "y86disasm.h"
+
+/*
+	An address or range and how often it was used, for sorting.
+*/
+
+typedef struct
+{
+	unsigned int at;
+	long long count;
+} Hot;
+
+static int hotter (const void * a, const void * b)
+{
+	const Hot * x = (const Hot *) a;
+	const Hot * y = (const Hot *) b;
+
+	if (x->count != y->count)
+	{
+		return x->count < y->count ? 1 : -1;
+	}
+	return x->at < y->at ? -1 : x->at > y->at;
+}
+
+/*
+	An empty profile of a program with memsize bytes of memory.
+	Returns NULL if there's no memory for it.
+*/
+
+Profile * profcreate (unsigned int memsize)
+{
+	Profile * prof = (Profile *) calloc(1, sizeof(Profile));
+
+	if (prof == NULL)
+	{
+		return NULL;
+	}
+	prof->memsize = memsize;
+	prof->nranges = (memsize + PROFRANGE - 1) / PROFRANGE + 1;
+	prof->reads = (long long *) calloc(prof->nranges, sizeof(long long));
+	prof->writes = (long long *) calloc(prof->nranges, sizeof(long long));
+
+	if (pctableinit(&prof->pccount, 1) != 0 || prof->reads == NULL || prof->writes == NULL)
+	{
+		proffree(prof);
+		return NULL;
+	}
+	return prof;
+}
+
+/*
+	Releases a profile.
+*/
+
+void proffree (Profile * prof)
+{
+	if (prof != NULL)
+	{
+		pctablefree(&prof->pccount);
+		free(prof->reads);
+		free(prof->writes);
+		free(prof);
+	}
+}
+
+/*
+	Prints the profile: every opcode that ran, the top hottest addresses
+	with their instructions disassembled from mem, and the top busiest
+	ranges of memory.
+*/
+
+void profreport (FILE * out, const Profile * prof, const unsigned char * mem, int top)
+{
+	long long total = 0;
+	unsigned int i, n;
+	unsigned int * at;
+	Hot * hot;
+	char text[64];
+	int op;
+
+	for (op = 0; op < 256; op++)
+	{
+		total += prof->opcount[op];
+	}
+
+	fprintf(out, "Profile of %lld instructions\n", total);
+	if (total == 0)
+	{
+		return;
+	}
+
+	fprintf(out, "\nOpcodes:\n");
+	for (op = 0; op < 256; op++)
+	{
+		if (prof->opcount[op] != 0)
+		{
+			const char * name = disname((unsigned char) op);
+			fprintf(out, "\t%02x  %-8s%14lld  %5.1f%%\n", op, name != NULL ? name : "invalid",
+				prof->opcount[op], 100.0 * prof->opcount[op] / total);
+		}
+	}
+
+	for (i = n = 0; i < prof->nranges; i++)
+	{
+		n += prof->reads[i] + prof->writes[i] != 0;
+	}
+	if (n < prof->pccount.npcs)
+	{
+		n = prof->pccount.npcs;
+	}
+	hot = (Hot *) malloc((n > 0 ? n : 1) * sizeof(Hot));
+	at = (unsigned int *) malloc((n > 0 ? n : 1) * sizeof(unsigned int));
+	if (hot == NULL || at == NULL)
+	{
+		free(hot);
+		free(at);
+		return;
+	}
+
+	n = pctablepcs(&prof->pccount, at);
+	for (i = 0; i < n; i++)
+	{
+		hot[i].at = at[i];
+		hot[i].count = *pcfind(&prof->pccount, at[i]);
+	}
+	qsort(hot, n, sizeof(Hot), hotter);
+
+	fprintf(out, "\nHot spots:\n");
+	if (prof->pccount.failed)
+	{
+		fprintf(out, "\t(out of memory, some pcs are missing)\n");
+	}
+	for (i = 0; i < n && (int) i < top; i++)
+	{
+		if (disasm(mem, prof->memsize, hot[i].at, text, sizeof(text)) == 0)
+		{
+			strcpy(text, "(invalid)");
+		}
+		fprintf(out, "\t%14lld  %5.1f%%  [0x%08x]\t%s\n", hot[i].count,
+			100.0 * hot[i].count / total, hot[i].at, text);
+	}
+
+	for (i = n = 0; i < prof->nranges; i++)
+	{
+		if (prof->reads[i] + prof->writes[i] != 0)
+		{
+			hot[n].at = i;
+			hot[n++].count = prof->reads[i] + prof->writes[i];
+		}
+	}
+	qsort(hot, n, sizeof(Hot), hotter);
+
+	fprintf(out, "\nMemory (%d byte ranges):\n", PROFRANGE);
+	for (i = 0; i < n && (int) i < top; i++)
+	{
+		unsigned int r = hot[i].at;
+
+		if (r == prof->nranges - 1)
+		{
+			fprintf(out, "\toutside memory     ");
+		}
+		else
+		{
+			fprintf(out, "\t%08x-%08x  ", r * PROFRANGE, r * PROFRANGE + PROFRANGE - 1);
+		}
+		fprintf(out, "%14lld reads %14lld writes\n", prof->reads[r], prof->writes[r]);
+	}
+
+	free(hot);
+	free(at);
+}
@@ -0,0 +1,65 @@
+// Ryan Bandilla
+// Y86 Profiler
+// BKR Comp Arch
+#ifndef Y86PROF_H
+#define Y86PROF_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "y86pctable.h"
+
+/*
+ *	Where a run spends its instructions: how often each pc and each
+ *	opcode was executed, and how many loads and stores went to each
+ *	PROFRANGE bytes of memory.  Accesses outside of memory are counted in
+ *	one extra range past the end.  Filled in through the probes, see
+ *	y86probe.h.
+ */
+
+#define PROFRANGESHIFT 8
+#define PROFRANGE (1 << PROFRANGESHIFT)
+
+typedef struct
+{
+	unsigned int memsize;
+	PcTable pccount;			//	Executions of each address that ran
+	long long opcount[256];		//	Executions of each opcode byte
+	long long * reads;			//	Loads from each range
+	long long * writes;			//	Stores to each range
+	unsigned int nranges;		//	Ranges of memory, and the one past it
+} Profile;
+
+Profile * profcreate (unsigned int memsize);
+void proffree (Profile * prof);
+void profreport (FILE * out, const Profile * prof, const unsigned char * mem, int top);
+
+static inline void profinsn (Profile * prof, unsigned int pc, unsigned char op)
+{
+	long long * count = pccounters(&prof->pccount, pc);
+
+	if (count != NULL)
+	{
+		(*count)++;
+	}
+	prof->opcount[op]++;
+}
+
+static inline void profaccess (Profile * prof, size_t addr, int write)
+{
+	size_t range = addr >> PROFRANGESHIFT;
+
+	if (range >= prof->nranges)
+	{
+		range = prof->nranges - 1;
+	}
+	if (write)
+	{
+		prof->writes[range]++;
+	}
+	else
+	{
+		prof->reads[range]++;
+	}
+}
+
+#endif
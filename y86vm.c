@@ -0,0 +1,1140 @@
+// Ryan Bandilla
+// Y86 Virtual Machine
+// BKR Comp Arch
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <stdatomic.h>
+#include "y86vm.h"
+#include "y86load.h"
+#include "y86hex.h"
+#include "y86image.h"
+#include "y86mem.h"
+#include "y86io.h"
+#include "y86decode.h"
+#include "y86jit.h"
+
+/*
+	Lazy condition codes.  An ALU instruction only records its result
+	(ccres, for ZF and SF) and, unless it leaves OF alone, how OF is to be
+	worked out from its operands.  FLAGS() turns them into ZF, SF and OF
+	when a jump or I/O instruction needs them, and before the state is
+	written back.
+*/
+
+enum
+{
+	OF_SET,		//	OF holds the flag
+	OF_ADD,		//	From ofa + ofb = ofres
+	OF_SUB,		//	From ofb - ofa = ofres
+	OF_MUL		//	From ofa * ofb = ofres
+};
+
+#define LAZYZS(res) (ccres = (res), cclazy = 1)
+#define LAZYOF(kind, a, b, res) (ofkind = (kind), ofa = (a), ofb = (b), ofres = (res))
+
+#define FLAGS() \
+	do \
+	{ \
+		if (cclazy) \
+		{ \
+			ZF = ccres == 0; \
+			SF = ccres < 0; \
+			cclazy = 0; \
+		} \
+		if (ofkind != OF_SET) \
+		{ \
+			OF = overflow(ofkind, ofa, ofb, ofres); \
+			ofkind = OF_SET; \
+		} \
+	} while (0)
+
+/*
+	OF as each ALU instruction has always set it.
+*/
+
+static inline int overflow (int kind, int num1, int num2, int value)
+{
+	switch (kind)
+	{
+		case OF_ADD:
+			return (value > 0 && num1 < 0 && num2 < 0) || (value < 0 && num1 > 0 && num2 > 0);
+
+		case OF_SUB:
+			return (value > 0 && num1 > 0 && num2 < 0) || (value < 0 && num1 < 0 && num2 > 0);
+
+		case OF_MUL:
+			return (value < 0 && num1 < 0 && num2 < 0) || 
+				(value < 0 && num1 > 0 && num2 > 0) || 
+				(value > 0 && num1 < 0 && num2 > 0) || 
+				(value > 0 && num1 > 0 && num2 < 0);
+	}
+	return 0;
+}
+
+/*
+	Whether any of the n bytes at the guest address a are outside of
+	memory, the .size bytes and the spare one past them.  a is a size_t
+	holding an unsigned 32 bit address, so neither side can wrap.
+*/
+
+#define OUTSIDE(a, n) ((a) + (n) > (size_t) memsize + 1)
+
+/*
+	For the guarded engine.  CROSSES() is whether the n bytes at a start
+	in memory and run off its end, which would fault only after the bytes
+	inside were written.  FAULTED() is whether the load just made hit a
+	guard page; the fence keeps the compiler from moving the load past
+	the look at status, which the fault handler sets.
+*/
+
+#define CROSSES(a, n) ((a) <= (size_t) memsize && OUTSIDE(a, n))
+#define FAULTED() (atomic_signal_fence(memory_order_seq_cst), status != AOK)
+
+/*
+	Calls into the probes from the handlers.  Empty in every engine but
+	the probed one in run(), which defines them for its own instance of
+	the handlers.
+*/
+
+#define PROBEREAD(a, n)
+#define PROBEWRITE(a, n)
+#define PROBECALL(ret, func)
+#define PROBERET(at, to)
+#define PROBEBRANCH(at, taken, to)
+
+/*
+	Instruction budget and time limit of a run.  The engines only compare
+	count against limit, at every CHECKPOINT() and on the way out of
+	translated code; everything else happens in budgetcheck() when limit
+	is reached.  With a time limit, limit comes every TIMESLICE
+	instructions so the clock is read that often.
+*/
+
+#define TIMESLICE (1 << 20)
+
+typedef struct
+{
+	long long limit;		//	count of the next check
+	long long steps;		//	Stop with the status unchanged
+	long long budget;		//	Stop with TMO
+	double deadline;		//	Stop with TMO, 0 for none
+} Budget;
+
+/*
+	Seconds on a monotonic clock, used for time limits.
+*/
+
+static double now ()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+	Sets up the budget of a run that is to stop after steps instructions.
+*/
+
+static void budgetstart (Budget * b, const VM * vm, long long steps)
+{
+	b->steps = steps;
+	b->budget = vm->budget > 0 ? vm->budget : LLONG_MAX;
+	b->deadline = vm->timeout > 0 ? now() + vm->timeout : 0;
+	b->limit = b->steps < b->budget ? b->steps : b->budget;
+
+	if (b->deadline != 0 && b->limit > TIMESLICE)
+	{
+		b->limit = TIMESLICE;
+	}
+}
+
+/*
+	Called once count has reached b->limit.  Returns the status to stop
+	the run with, or -1 to carry on to the new b->limit.
+*/
+
+static int budgetcheck (Budget * b, long long count)
+{
+	if (count >= b->budget)
+	{
+		return TMO;
+	}
+	if (count >= b->steps)
+	{
+		return AOK;
+	}
+	if (b->deadline != 0 && now() >= b->deadline)
+	{
+		return TMO;
+	}
+
+	b->limit = b->steps < b->budget ? b->steps : b->budget;
+	if (b->deadline != 0 && b->limit - count > TIMESLICE)
+	{
+		b->limit = count + TIMESLICE;
+	}
+	return -1;
+}
+
+/*
+	What the handlers do after a taken jump, call or return: leave the
+	engine once the run is out of budget or time, or has done its steps.
+*/
+
+#define CHECKPOINT() \
+	do \
+	{ \
+		if (count >= budget.limit && (stopstatus = budgetcheck(&budget, count)) >= 0) \
+		{ \
+			status = stopstatus; \
+			goto stopped; \
+		} \
+	} while (0)
+
+/*
+	Runs the program from the VM's state with the given engine, or the
+	probed one if the VM has probes, until it stops, runs out of budget or
+	time, or has run steps instructions.  The switch and probed engines
+	stop after exactly steps, the others at the first taken jump, call or
+	return after them.
+*/
+
+static void run (VM * vm, Engine engine, long long steps)
+{
+	unsigned char arg1;
+	unsigned char arg2;
+	
+	int value;			// Used for any integer operations
+
+	int num1, num2;		// Used in addl, subl, mull, 
+
+	size_t addr;		// Guest address of a load or store
+
+	Decoded * d;		// Decoded form of the instruction at pc
+
+	int badscan;
+
+	char inputchar = 0; 	// For read/write b
+	int inputword = 0;		// For read/write w
+
+	// The machine state is run in locals.  A store into memspace could
+	// alias anything reached through vm, so the compiler would reload it
+	// after every store; nothing can alias a local.  Written back at the end.
+	int pc = vm->pc;
+	int reg[8];
+	int OF = vm->OF, ZF = vm->ZF, SF = vm->SF;
+	ProgramStatus status = vm->status;
+	unsigned char * memspace = vm->memspace;
+	int memsize = vm->memsize;
+	FILE * out = vm->out;
+	GuestIO io;
+
+	int ccres = 0, cclazy = 0;				// See FLAGS()
+	int ofkind = OF_SET, ofa = 0, ofb = 0, ofres = 0;
+
+	DecodeCache * dc = &vm->dcache;
+	Decoded * entries = dc->entries;
+	unsigned int dsize = dc->size;
+	long long count = 0;
+	Budget budget;
+	int stopstatus;
+	Probes * probes = vm->probes;
+
+	memcpy(reg, vm->reg, sizeof(reg));
+	budgetstart(&budget, vm, steps);
+	iobegin(&io, vm->in, out);
+
+	if (probes != NULL)
+	{
+		// The switch engine with every instruction and access reported to
+		// the probes
+#define OP(h) case h:
+#define NEXT break
+#undef PROBEREAD
+#undef PROBEWRITE
+#undef PROBECALL
+#undef PROBERET
+#undef PROBEBRANCH
+#define PROBEREAD(a, n) probeaccess(probes, a, n, 0)
+#define PROBEWRITE(a, n) probeaccess(probes, a, n, 1)
+#define PROBECALL(ret, func) probecall(probes, ret, func)
+#define PROBERET(at, to) proberet(probes, at, to)
+#define PROBEBRANCH(at, taken, to) probebranch(probes, at, taken, to)
+
+		while (status == AOK && (unsigned int) pc < dsize && count < steps)
+		{
+			d = &entries[pc];
+			arg1 = d->ra;
+			arg2 = d->rb;
+			count++;
+
+			if (d->handler != H_DECODE)
+			{
+				probeinsn(probes, pc, memspace[pc]);
+			}
+
+			switch (d->handler)
+			{
+#include "y86ops.h"
+			}
+		}
+
+#undef OP
+#undef NEXT
+#undef PROBEREAD
+#undef PROBEWRITE
+#undef PROBECALL
+#undef PROBERET
+#undef PROBEBRANCH
+#define PROBEREAD(a, n)
+#define PROBEWRITE(a, n)
+#define PROBECALL(ret, func)
+#define PROBERET(at, to)
+#define PROBEBRANCH(at, taken, to)
+	}
+	else if (engine == ENGINE_THREADED)
+	{
+#ifdef HAVE_THREADED
+		// Threaded code: every handler ends in its own indirect jump to the
+		// next handler, so the host predicts each one separately instead of
+		// sharing the one jump of the switch
+		static const void * handlers[] =
+		{
+			[H_DECODE] = &&L_H_DECODE, [H_NOP] = &&L_H_NOP, [H_HALT] = &&L_H_HALT,
+			[H_RRMOVL] = &&L_H_RRMOVL, [H_IRMOVL] = &&L_H_IRMOVL,
+			[H_RMMOVL] = &&L_H_RMMOVL, [H_MRMOVL] = &&L_H_MRMOVL,
+			[H_ADDL] = &&L_H_ADDL, [H_SUBL] = &&L_H_SUBL, [H_ANDL] = &&L_H_ANDL,
+			[H_XORL] = &&L_H_XORL, [H_MULL] = &&L_H_MULL, [H_CMPL] = &&L_H_CMPL,
+			[H_JMP] = &&L_H_JMP, [H_JLE] = &&L_H_JLE, [H_JL] = &&L_H_JL,
+			[H_JE] = &&L_H_JE, [H_JNE] = &&L_H_JNE, [H_JGE] = &&L_H_JGE,
+			[H_JG] = &&L_H_JG, [H_CALL] = &&L_H_CALL, [H_RET] = &&L_H_RET,
+			[H_PUSHL] = &&L_H_PUSHL, [H_POPL] = &&L_H_POPL,
+			[H_READB] = &&L_H_READB, [H_READL] = &&L_H_READL,
+			[H_WRITEB] = &&L_H_WRITEB, [H_WRITEL] = &&L_H_WRITEL,
+			[H_MOVSBL] = &&L_H_MOVSBL, [H_INVALID] = &&L_H_INVALID
+		};
+
+#define OP(h) L_##h:
+#define NEXT \
+		do \
+		{ \
+			if (status != AOK || (unsigned int) pc >= dsize) \
+			{ \
+				goto stopped; \
+			} \
+			d = &entries[pc]; \
+			arg1 = d->ra; \
+			arg2 = d->rb; \
+			count++; \
+			goto *handlers[d->handler]; \
+		} while (0)
+
+		NEXT;
+#include "y86ops.h"
+
+#undef OP
+#undef NEXT
+#endif
+	}
+#ifdef HAVE_JIT
+	else if (engine == ENGINE_JIT)
+	{
+		// Blocks run as translated code, the interpreter takes every
+		// instruction the translated code can't
+		JitState js;
+		unsigned char * block;
+		Jit * jit = &vm->jit;
+		long long codewrites = dc->codewrites;
+		int step = 0;
+		int h;
+
+		if (jit->code == NULL && jitinit(jit, dsize) != 0)
+		{
+			fprintf(out, "ERROR: Could not allocate the JIT\n");
+			status = ADR;
+			dsize = 0;
+		}
+		js.memsize = dsize;
+
+#define OP(h) case h:
+#define NEXT break
+
+		while (status == AOK && (unsigned int) pc < dsize)
+		{
+			if (!step && (block = jitblock(jit, dc, memspace, pc)) != NULL)
+			{
+				FLAGS();
+				memcpy(js.reg, reg, sizeof(reg));
+				js.OF = OF;
+				js.ZF = ZF;
+				js.SF = SF;
+				js.count = 0;
+				js.limit = budget.limit - count;
+
+				jitrun(jit, &js, block, memspace, dc->code);
+
+				memcpy(reg, js.reg, sizeof(reg));
+				OF = js.OF;
+				ZF = js.ZF;
+				SF = js.SF;
+				pc = js.pc;
+				step = js.step;
+				count += js.count;
+
+				// The blocks check the budget as they are entered
+				if (count >= budget.limit && (stopstatus = budgetcheck(&budget, count)) >= 0)
+				{
+					status = stopstatus;
+					break;
+				}
+
+				// Chain the way out to where it led
+				if (!step && js.link != NULL)
+				{
+					jitlink(jit, &js, jitblock(jit, dc, memspace, pc));
+				}
+				continue;
+			}
+
+			d = &entries[pc];
+			h = d->handler;
+			arg1 = d->ra;
+			arg2 = d->rb;
+			count++;
+
+			switch (d->handler)
+			{
+#include "y86ops.h"
+			}
+
+			if (h != H_DECODE)
+			{
+				step = 0;
+			}
+
+			// A store into code throws the translations away
+			if (dc->codewrites != codewrites)
+			{
+				codewrites = dc->codewrites;
+				jitmodified(jit, dc->lastwrite, 4);
+			}
+		}
+
+#undef OP
+#undef NEXT
+	}
+#endif
+	else
+	{
+		// One switch on the handler of each instruction, the only engine
+		// that can stop after any instruction for vmstep()
+#define OP(h) case h:
+#define NEXT break
+
+		while (status == AOK && (unsigned int) pc < dsize && count < steps)
+		{
+			d = &entries[pc];
+			arg1 = d->ra;
+			arg2 = d->rb;
+			count++;
+
+			switch (d->handler)
+			{
+#include "y86ops.h"
+			}
+		}
+
+#undef OP
+#undef NEXT
+	}
+
+stopped:
+	// Every way out of the engines but running off the end of memory or
+	// the steps sets the status
+	ioflush(&io);
+	if (status == TMO)
+	{
+		fprintf(out, "ERROR: Program ran out of %s. Memory Location: %x\n",
+			count >= budget.budget ? "instructions" : "time", pc);
+	}
+	else if (status == AOK && (unsigned int) pc >= dsize)
+	{
+		status = ADR;
+		fprintf(out, "ERROR: Instruction outside of memory space. Memory Location: %x\n", pc);
+	}
+
+	FLAGS();
+
+	vm->pc = pc;
+	memcpy(vm->reg, reg, sizeof(reg));
+	vm->OF = OF;
+	vm->ZF = ZF;
+	vm->SF = SF;
+	vm->status = status;
+	vm->icount += count;
+}
+
+/*
+	The switch engine on guarded memory.  Handlers are built with GUARDED,
+	so loads and stores aren't checked; a fault on the guard pages sets
+	status, which is volatile for that, and the loop stops after the
+	instruction that faulted.  Like the switch engine in run() it stops
+	after exactly steps instructions.
+*/
+
+static void runguarded (VM * vm, long long steps)
+{
+	unsigned char arg1;
+	unsigned char arg2;
+	
+	int value;
+	int num1, num2;
+	size_t addr;
+	Decoded * d = NULL;
+	int badscan;
+	char inputchar = 0;
+	int inputword = 0;
+
+	int pc = vm->pc;
+	int reg[8];
+	int OF = vm->OF, ZF = vm->ZF, SF = vm->SF;
+	volatile int status = vm->status;
+	unsigned char * memspace = vm->memspace;
+	int memsize = vm->memsize;
+	FILE * out = vm->out;
+	GuestIO io;
+	unsigned int badaddr;
+
+	int ccres = 0, cclazy = 0;
+	int ofkind = OF_SET, ofa = 0, ofb = 0, ofres = 0;
+
+	DecodeCache * dc = &vm->dcache;
+	Decoded * entries = dc->entries;
+	unsigned int dsize = dc->size;
+	long long count = 0;
+	Budget budget;
+	int stopstatus;
+
+	memcpy(reg, vm->reg, sizeof(reg));
+	budgetstart(&budget, vm, steps);
+	iobegin(&io, vm->in, out);
+
+	if (guardbegin(memspace, &status, ADR) != 0)
+	{
+		fprintf(out, "ERROR: Could not catch faults on guarded memory\n");
+		status = ADR;
+	}
+
+#define GUARDED
+#define OP(h) case h:
+#define NEXT break
+
+	while (status == AOK && (unsigned int) pc < dsize && count < steps)
+	{
+		d = &entries[pc];
+		arg1 = d->ra;
+		arg2 = d->rb;
+		count++;
+
+		switch (d->handler)
+		{
+#include "y86ops.h"
+		}
+	}
+
+#undef OP
+#undef NEXT
+#undef GUARDED
+
+stopped:
+	ioflush(&io);
+	if (guardend(&badaddr))
+	{
+		fprintf(out, "ERROR: Invalid address %x. Memory Location: %x\n",
+			badaddr, (int) (d - entries));
+	}
+	else if (status == TMO)
+	{
+		fprintf(out, "ERROR: Program ran out of %s. Memory Location: %x\n",
+			count >= budget.budget ? "instructions" : "time", pc);
+	}
+	else if (status == AOK && (unsigned int) pc >= dsize)
+	{
+		status = ADR;
+		fprintf(out, "ERROR: Instruction outside of memory space. Memory Location: %x\n", pc);
+	}
+
+	FLAGS();
+
+	vm->pc = pc;
+	memcpy(vm->reg, reg, sizeof(reg));
+	vm->OF = OF;
+	vm->ZF = ZF;
+	vm->SF = SF;
+	vm->status = status;
+	vm->icount += count;
+}
+
+/*
+	Makes an empty VM.  Returns NULL if there's no memory for it.
+*/
+
+VM * vmcreate ()
+{
+	VM * vm = (VM *) calloc(1, sizeof(VM));
+
+	if (vm == NULL)
+	{
+		return NULL;
+	}
+
+	vm->engine = DEFAULTENGINE;
+	vm->status = AOK;
+	vm->in = stdin;
+	vm->out = stdout;
+	return vm;
+}
+
+/*
+	vm->loaded has a byte for every 1 << LOADSHIFT bytes of memory, set
+	where loading the program wrote to it.  The rest of memory is still
+	zero, so vmcopy() only has to copy those.
+*/
+
+#define LOADSHIFT 12
+
+static size_t loadmapsize (unsigned int size)
+{
+	return ((size_t) size >> LOADSHIFT) + 1;
+}
+
+/*
+	Starts a map of what loading the program writes, once there is
+	memory for it.  Without one vmcopy() copies all of memory.
+*/
+
+static void loadmapbegin (VM * vm)
+{
+	vm->loaded = memalloc(loadmapsize(vm->memsize), 1);
+}
+
+/*
+	Notes that loading the program wrote the n bytes at addr.
+*/
+
+static void loadmapmark (VM * vm, unsigned int addr, unsigned int n)
+{
+	size_t k;
+
+	if (vm->loaded == NULL || n == 0)
+	{
+		return;
+	}
+	for (k = addr >> LOADSHIFT; k <= ((size_t) addr + n - 1) >> LOADSHIFT; k++)
+	{
+		vm->loaded[k] = 1;
+	}
+}
+
+/*
+	Drops the map once a run could have written anywhere.
+*/
+
+static void loadmapend (VM * vm)
+{
+	if (vm->loaded != NULL)
+	{
+		memfree(vm->loaded, loadmapsize(vm->memsize));
+		vm->loaded = NULL;
+	}
+}
+
+/*
+	Releases the memory and caches of a VM's program, if it has one.
+*/
+
+static void vmunload (VM * vm)
+{
+	if (vm->memspace != NULL && vm->guarded)
+	{
+		memunguard(vm->memspace, vm->memsize);
+	}
+	else if (vm->memspace != NULL)
+	{
+		memfree(vm->memspace, vm->memsize);
+	}
+	loadmapend(vm);
+	dcachefree(&vm->dcache);
+#ifdef HAVE_JIT
+	jitfree(&vm->jit);
+#endif
+	vm->memspace = NULL;
+	vm->memsize = 0;
+}
+
+/*
+	Releases a VM and everything it holds.
+*/
+
+void vmdestroy (VM * vm)
+{
+	if (vm != NULL)
+	{
+		vmunload(vm);
+		free(vm);
+	}
+}
+
+/*
+	Gives the VM memory and a machine state to start from: registers and
+	flags 0, status AOK.  mem is from memalloc(), or NULL for new zeroed
+	memory of the kind the VM asks for.  Returns -1, with the VM left
+	empty, if there's no memory or the decode cache can't be set up.
+*/
+
+static int vmreset (VM * vm, unsigned char * mem, int size)
+{
+	vmunload(vm);
+
+	memset(vm->reg, 0, sizeof(vm->reg));
+	vm->pc = 0;
+	vm->OF = vm->ZF = vm->SF = 0;
+	vm->status = AOK;
+	vm->guarded = 0;
+
+	if (mem == NULL && vm->guard)
+	{
+		mem = memguard(size, vm->noreserve);
+		vm->guarded = 1;
+	}
+	else if (mem == NULL)
+	{
+		mem = memalloc(size, vm->noreserve);
+	}
+	if (mem == NULL)
+	{
+		vm->guarded = 0;
+		return -1;
+	}
+
+	vm->memspace = mem;
+	vm->memsize = size;
+
+	if (dcacheinit(&vm->dcache, size) != 0)
+	{
+		vmunload(vm);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+	Bytes of memory a directive writes, from its address on, and its name.
+*/
+
+static unsigned int directivebytes (const Directive * d, const char ** name)
+{
+	switch (d->kind)
+	{
+		case DIR_TEXT:
+			*name = ".text";
+			return (d->length + 1) / 2;
+
+		case DIR_BYTE:
+			*name = ".byte";
+			return 1;
+
+		case DIR_LONG:
+			*name = ".long";
+			return 4;
+
+		case DIR_STRING:
+			*name = ".string";
+			return d->length >= 2 ? d->length - 2 : 0;
+	}
+	*name = NULL;
+	return 0;
+}
+
+/*
+	Sizes memory from the .size directive and applies the others to it.
+	Returns 0 on success, or prints the problem and returns -1.
+*/
+
+int vmloadsource (VM * vm, const Source * src)
+{
+	const Directive * dirs = src->dirs;
+	const Directive * d;
+	int ndirs = src->ndirs;
+	int j, t;
+	int count = 0;
+	int size = 0;
+	// First must find the .size directive
+	
+	for (t = 0; t < ndirs; t++)
+	{
+		if (dirs[t].kind == DIR_SIZE)
+		{
+			if (count == 0)
+			{	
+				count++;
+			}
+			else
+			{
+				printf("ERROR:\n\t More than one .size directive has been detected. \n");
+				printf("\t Please make sure that the file has exactly one .size directive \n");
+				return -1;
+			}
+			size = dirs[t].address;
+		}
+	}
+
+	if (count == 0)				//	Check to make sure there was a .size direvtive found in the file
+	{
+		printf("ERROR:\n\t No .size directive was detected in the .y86 file. \n\t Please make sure that the file has exactly one .size directive\n");
+		return -1;
+	}
+	
+	// Intialize emulators memory space
+	
+	//	Pages are zero filled by the kernel the first time they are touched
+	
+	if (vmreset(vm, NULL, size) != 0)
+	{
+		printf("ERROR: Could not allocate %u bytes of memory for the .size directive\n", size);
+		return -1;
+	}
+
+	unsigned char * memspace = vm->memspace;
+	int pc = -1;
+
+	loadmapbegin(vm);
+	
+	// Apply the other directives
+	
+	int ai = 0;		//	AddressIndex dec representation of hex address in memory
+	const char * name;
+	unsigned int bytes;
+	
+	for (t = 0; t < ndirs; t++)
+	{
+		d = &dirs[t];
+		ai = d->address;
+
+		//	Nothing may be written past the end of memory
+		bytes = directivebytes(d, &name);
+		if (name != NULL && (unsigned long long) d->address + bytes > (unsigned long long) size)
+		{
+			printf("ERROR: %s directive at address %x runs past the end of memory (.size %x)\n",
+				name, d->address, size);
+			return -1;
+		}
+		loadmapmark(vm, d->address, bytes);
+
+		if (d->kind == DIR_TEXT)
+		{
+			if (pc == -1)
+			{
+				pc = ai;
+			}
+			else if (pc != -1)
+			{
+				printf("ERROR: More than one .text directive detected\n");
+				return -1;
+			}
+			
+			hextobytes(d->payload, d->length, &memspace[ai]);
+			vm->pc = pc;
+		}
+		else if (d->kind == DIR_BYTE)
+		{
+			memspace[ai] = (unsigned char) directivevalue(d);
+		}
+		else if (d->kind == DIR_LONG)
+		{
+			store32(memspace + ai, directivevalue(d));
+		}
+		else if (d->kind == DIR_STRING)
+		{
+			//	Copy the characters between the quotes
+			for(j = 1; j < (int) d->length - 1; j++)
+			{
+				memspace[ai] = (unsigned char) d->payload[j];
+				ai++;
+			}
+		}
+		else if (d->kind == DIR_INVALID)
+		{
+			printf("ERROR: Invalid directive encountered: %.*s\n", (int) d->length, d->payload);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*
+	Loads the .y86 program held in text, which doesn't need to be '\0'
+	terminated.  Returns 0 on success, or -1.
+*/
+
+int vmloadbuffer (VM * vm, const char * text, size_t length)
+{
+	Source src;
+	int ret;
+
+	memset(&src, 0, sizeof(src));
+	src.text = text;
+	src.length = length;
+
+	if (parsesource(&src) != 0)
+	{
+		return -1;
+	}
+
+	ret = vmloadsource(vm, &src);
+	free(src.dirs);
+	return ret;
+}
+
+/*
+	Loads a .y86b image, see mapimage() for hash.
+	Returns 0 on success, or -1 if it isn't a usable image.
+*/
+
+int vmloadimage (VM * vm, const char * name, unsigned long long hash)
+{
+	Image img;
+	unsigned int at, n, k;
+
+	if (mapimage(name, hash, &img) != 0)
+	{
+		return -1;
+	}
+
+	// Guarded memory has to sit in its window, so the image is copied in,
+	// all but the parts that are zero
+	if (vm->guard)
+	{
+		if (vmreset(vm, NULL, img.memsize) != 0)
+		{
+			unmapimage(&img);
+			return -1;
+		}
+		loadmapbegin(vm);
+		for (at = 0; at < img.memsize; at += n)
+		{
+			n = img.memsize - at < (1u << LOADSHIFT) ? img.memsize - at : 1u << LOADSHIFT;
+			k = 0;
+			while (k < n && img.mem[at + k] == 0)
+			{
+				k++;
+			}
+			if (k < n)
+			{
+				memcpy(vm->memspace + at, img.mem + at, n);
+				loadmapmark(vm, at, n);
+			}
+		}
+		unmapimage(&img);
+	}
+	else if (vmreset(vm, img.mem, img.memsize) != 0)
+	{
+		return -1;
+	}
+	vm->pc = img.pc;
+	return 0;
+}
+
+/*
+	Loads a .y86 file or a .y86b image, by its extension.
+	Returns 0 on success, or -1.
+*/
+
+int vmloadfile (VM * vm, const char * name)
+{
+	const char * ext = strrchr(name, '.');
+	Source src;
+	int ret;
+
+	if (ext != NULL && strcmp(ext, ".y86b") == 0)
+	{
+		return vmloadimage(vm, name, 0);
+	}
+
+	if (loadsource(name, &src) != 0)
+	{
+		return -1;
+	}
+
+	ret = vmloadsource(vm, &src);
+	freesource(&src);
+	return ret;
+}
+
+/*
+	Whether vm's caches still hold what from's memory decodes to: the
+	decoded bytes of vm's last run all still match from and none were
+	stored into while it ran.
+*/
+
+static int vmcachesmatch (const VM * vm, const VM * from)
+{
+	const unsigned char * code = vm->dcache.code;
+	unsigned int i;
+
+	if (vm->memspace == NULL || vm->memsize != from->memsize ||
+		vm->guarded != from->guarded || vm->dcache.codewrites != 0)
+	{
+		return 0;
+	}
+	for (i = vm->dcache.codestart; i < vm->dcache.codeend; i++)
+	{
+		if (code[i] != 0 && vm->memspace[i] != from->memspace[i])
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+	Makes vm a fresh copy of the loaded program in from, ready to run it
+	again without loading it again.  vm keeps its own streams and, when it
+	last ran the same code, its decode cache and translations.  Its memory
+	starts out zero, new or cleared, and only the parts of from's memory
+	its load wrote are copied in, so a copy costs what the load and the
+	last run touched rather than the .size.
+	Returns 0 on success, or -1 with vm left empty.
+*/
+
+int vmcopy (VM * vm, const VM * from)
+{
+	size_t k, at, n;
+
+	vm->noreserve = from->noreserve;
+	vm->guard = from->guarded;
+
+	if (!vmcachesmatch(vm, from))
+	{
+		if (vmreset(vm, NULL, from->memsize) != 0)
+		{
+			return -1;
+		}
+	}
+	else if (memclear(vm->memspace, vm->memsize, vm->noreserve) != 0)
+	{
+		vmunload(vm);
+		return -1;
+	}
+
+	if (from->loaded == NULL)
+	{
+		memcpy(vm->memspace, from->memspace, from->memsize);
+	}
+	else
+	{
+		for (k = 0; k < loadmapsize(from->memsize); k++)
+		{
+			at = k << LOADSHIFT;
+			if (from->loaded[k] && at < (size_t) from->memsize)
+			{
+				n = from->memsize - at < (1u << LOADSHIFT) ? from->memsize - at : 1u << LOADSHIFT;
+				memcpy(vm->memspace + at, from->memspace + at, n);
+			}
+		}
+	}
+	memcpy(vm->reg, from->reg, sizeof(vm->reg));
+	vm->pc = from->pc;
+	vm->OF = from->OF;
+	vm->ZF = from->ZF;
+	vm->SF = from->SF;
+	vm->status = from->status;
+	vm->engine = from->engine;
+	vm->budget = from->budget;
+	vm->timeout = from->timeout;
+	return 0;
+}
+
+/*
+	Runs the program until it stops, with the VM's engine, or the guarded
+	interpreter if it is in guarded memory.
+	Returns the status it stopped with.
+*/
+
+ProgramStatus vmrun (VM * vm)
+{
+	loadmapend(vm);
+	if (vm->guarded)
+	{
+		runguarded(vm, LLONG_MAX);
+	}
+	else
+	{
+		run(vm, vm->engine, LLONG_MAX);
+	}
+	return vm->status;
+}
+
+/*
+	Runs n more instructions, or fewer if the program stops first.
+	Stepping always uses the switch engine, or the guarded one.
+	Returns the status, AOK if the program hasn't stopped.
+*/
+
+ProgramStatus vmstep (VM * vm, long long n)
+{
+	loadmapend(vm);
+	if (vm->guarded)
+	{
+		runguarded(vm, n);
+	}
+	else
+	{
+		run(vm, ENGINE_SWITCH, n);
+	}
+	return vm->status;
+}
+
+/*
+	Copies n bytes of memory at addr into buf.
+	Returns 0, or -1 if they aren't all inside memory.
+*/
+
+int vmreadmem (const VM * vm, unsigned int addr, void * buf, unsigned int n)
+{
+	if ((unsigned long long) addr + n > (unsigned long long) vm->memsize)
+	{
+		return -1;
+	}
+	memcpy(buf, vm->memspace + addr, n);
+	return 0;
+}
+
+/*
+	Short name of a status, as the batch and the benchmark print it
+*/
+
+const char * statusname (ProgramStatus status)
+{
+	switch (status)
+	{
+		case AOK:
+			return "AOK";
+
+		case HLT:
+			return "HLT";
+
+		case ADR:
+			return "ADR";
+
+		case INS:
+			return "INS";
+
+		case TMO:
+			return "TMO";
+	}
+	return "???";
+}
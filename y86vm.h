@@ -0,0 +1,121 @@
+// Ryan Bandilla
+// Y86 Virtual Machine
+// BKR Comp Arch
+#ifndef Y86VM_H
+#define Y86VM_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "y86load.h"
+#include "y86decode.h"
+#include "y86jit.h"
+#include "y86probe.h"
+
+/*
+ *	Execution state of the emulated program
+ *
+ *	AOK - No errors detected from start to current position
+ *	HLT - Halt program execution
+ *	ADR - Program encountered an invalid or bad address
+ *	INS - Invalid instruction encountered
+ *	TMO - The run used up its instruction budget or time limit
+ *
+ *	If the program enters either the HLT, ADR, INS or TMO state
+ *	execution will cease
+ */
+
+typedef enum
+{
+	AOK,
+	HLT,
+	ADR,
+	INS,
+	TMO
+} ProgramStatus;
+
+/*
+ *	How the VM dispatches instructions.  The threaded engine needs labels
+ *	as values (GCC and Clang), define Y86_NOTHREADED to leave it out.
+ */
+
+#if defined(__GNUC__) && !defined(Y86_NOTHREADED)
+#define HAVE_THREADED 1
+#endif
+
+typedef enum
+{
+	ENGINE_SWITCH,		//	One switch on the handler of each instruction
+	ENGINE_THREADED,	//	Computed goto from handler to handler
+	ENGINE_JIT			//	Basic blocks translated to x86-64, see y86jit.h
+} Engine;
+
+#ifdef HAVE_THREADED
+#define DEFAULTENGINE ENGINE_THREADED
+#else
+#define DEFAULTENGINE ENGINE_SWITCH
+#endif
+
+/*
+ *	One emulated machine.  Nothing is shared between VMs, so any number of
+ *	them can be loaded and run at once, each by one thread at a time.
+ *
+ *	The state can be read directly between runs.  vmcreate() gives an
+ *	empty VM with the default engine reading stdin and writing stdout; set
+ *	engine, noreserve and guard before loading, and in, out, budget and
+ *	timeout before running, to change them.
+ *
+ *	budget and timeout are only checked on jumps, calls and returns, so a
+ *	run can go a little past them before stopping with TMO.
+ *
+ *	With probes set, every run goes through the probed switch engine so
+ *	the models in it see each instruction and access (see y86probe.h).
+ *	Guarded runs leave the probes out.
+ *
+ *	Every engine checks each load and store against memsize and stops the
+ *	program with ADR before an access outside of memory.  A VM loaded with
+ *	guard set runs in guarded memory (see y86mem.h) on an interpreter
+ *	that leaves those checks to the guard pages instead.
+ */
+
+typedef struct
+{
+	int reg[8];					//	%eax %ecx %edx %ebx %esp %ebp %esi %edi
+	int pc;						//	Address of the next instruction
+	int OF, ZF, SF;				//	Condition codes, 0 or 1
+	ProgramStatus status;
+
+	unsigned char * memspace;	//	Memory, from memalloc()
+	int memsize;				//	Bytes of memory, the .size directive
+	unsigned char * loaded;		//	Parts of memory the load wrote, until a run, see vmcopy()
+
+	Engine engine;
+	int noreserve;				//	Map memory with MAP_NORESERVE, see y86mem.h
+	int guard;					//	Load into guarded memory
+	int guarded;				//	memspace is from memguard()
+	long long icount;			//	Instructions executed by every run so far
+	long long budget;			//	Instructions one run may execute, 0 for any
+	double timeout;				//	Seconds one run may take, 0 for any
+
+	FILE * in;					//	Read by READB and READL
+	FILE * out;					//	Written by WRITEB, WRITEL and run time errors
+	Probes * probes;			//	Models watching the runs, or NULL
+
+	DecodeCache dcache;
+#ifdef HAVE_JIT
+	Jit jit;
+#endif
+} VM;
+
+VM * vmcreate ();
+void vmdestroy (VM * vm);
+int vmloadsource (VM * vm, const Source * src);
+int vmloadbuffer (VM * vm, const char * text, size_t length);
+int vmloadimage (VM * vm, const char * name, unsigned long long hash);
+int vmloadfile (VM * vm, const char * name);
+int vmcopy (VM * vm, const VM * from);
+ProgramStatus vmrun (VM * vm);
+ProgramStatus vmstep (VM * vm, long long n);
+int vmreadmem (const VM * vm, unsigned int addr, void * buf, unsigned int n);
+const char * statusname (ProgramStatus status);
+
+#endif